@@ -22,13 +22,6 @@ protected:
 
 	virtual Vector<String> get_added_functions() const override { return {"polar2cartesian", "cartesian2polar"}; }
 public:
-	virtual String get_function_name(int p_func) const override;
-	virtual int get_function_count() const override;
-	virtual Pair<int, int> get_function_arg_count(int p_func) const override;
-	virtual int get_token_max() const override;
-	virtual int get_function_index(const String &p_func) const override;
-	virtual GDScriptDecomp::GlobalToken get_global_token(int p_token) const override;
-	virtual int get_local_token_val(GDScriptDecomp::GlobalToken p_token) const override;
 	virtual int get_bytecode_version() const override { return bytecode_version; }
 	virtual int get_bytecode_rev() const override { return bytecode_rev; }
 	virtual int get_engine_ver_major() const override { return engine_ver_major; }
@@ -36,6 +29,6 @@ public:
 	virtual int get_parent() const override { return parent; }
 	virtual String get_engine_version() const override { return engine_version; }
 	virtual String get_max_engine_version() const override { return max_engine_version; }
-	GDScriptDecomp_054a2ac() {}
+	GDScriptDecomp_054a2ac();
 };
 
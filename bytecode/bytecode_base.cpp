@@ -20,9 +20,19 @@
 #include "core/io/file_access_encrypted.h"
 #include "core/io/marshalls.h"
 #include "core/object/class_db.h"
+#include "core/templates/local_vector.h"
 #include "modules/gdscript/gdscript_tokenizer_buffer.h"
 
 #include <limits.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define GDRE_XOR_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define GDRE_XOR_NEON
+#endif
 
 #define GDSDECOMP_FAIL_V_MSG(m_retval, m_msg) \
 	error_message = RTR(m_msg);               \
@@ -115,6 +125,19 @@ Error GDScriptDecomp::decompile_byte_code(const String &p_path) {
 }
 
 Error GDScriptDecomp::get_buffer_encrypted(const String &p_path, int engine_ver_major, Vector<uint8_t> p_key, Vector<uint8_t> &bytecode) {
+	// Scripts from the loaded project are decrypted once and shared between revision detection, string loading and decompilation.
+	GDRESettings *settings = GDRESettings::get_singleton();
+	if (settings && settings->get_cached_decrypted_script(p_path, engine_ver_major, p_key, bytecode)) {
+		return OK;
+	}
+	Error err = _decrypt_buffer(p_path, engine_ver_major, p_key, bytecode);
+	if (err == OK && settings) {
+		settings->cache_decrypted_script(p_path, engine_ver_major, p_key, bytecode);
+	}
+	return err;
+}
+
+Error GDScriptDecomp::_decrypt_buffer(const String &p_path, int engine_ver_major, const Vector<uint8_t> &p_key, Vector<uint8_t> &bytecode) {
 	Ref<FileAccess> fa = FileAccess::open(p_path, FileAccess::READ);
 	ERR_FAIL_COND_V(fa.is_null(), ERR_FILE_CANT_OPEN);
 
@@ -174,6 +197,99 @@ int decompress_buf(const Vector<uint8_t> &p_buffer, Vector<uint8_t> &contents) {
 	return result;
 }
 
+// Identifiers are stored XOR-ed with 0xb6; decode 16 bytes at a time where SIMD is available.
+static _FORCE_INLINE_ void _xor_decode(uint8_t *p_dst, const uint8_t *p_src, size_t p_len) {
+	size_t i = 0;
+#if defined(GDRE_XOR_SSE2)
+	const __m128i key = _mm_set1_epi8((char)0xb6);
+	for (; i + 16 <= p_len; i += 16) {
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p_src + i));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(p_dst + i), _mm_xor_si128(v, key));
+	}
+#elif defined(GDRE_XOR_NEON)
+	const uint8x16_t key = vdupq_n_u8(0xb6);
+	for (; i + 16 <= p_len; i += 16) {
+		vst1q_u8(p_dst + i, veorq_u8(vld1q_u8(p_src + i), key));
+	}
+#endif
+	for (; i + 8 <= p_len; i += 8) {
+		uint64_t w;
+		memcpy(&w, p_src + i, 8);
+		w ^= 0xb6b6b6b6b6b6b6b6ULL;
+		memcpy(p_dst + i, &w, 8);
+	}
+	for (; i < p_len; i++) {
+		p_dst[i] = p_src[i] ^ 0xb6;
+	}
+}
+
+Error GDScriptDecomp::get_tokenizer_contents(const Vector<uint8_t> &p_buffer, Span<uint8_t> &r_contents) {
+	ERR_FAIL_COND_V(p_buffer.size() < 12, ERR_INVALID_DATA);
+	const uint8_t *buf = p_buffer.ptr();
+	const uint32_t decompressed_size = decode_uint32(&buf[8]);
+	if (decompressed_size == 0) {
+		r_contents = Span<uint8_t>(&buf[12], p_buffer.size() - 12);
+		return OK;
+	}
+	thread_local LocalVector<uint8_t> decompress_buffer;
+	if (decompress_buffer.size() < decompressed_size) {
+		decompress_buffer.resize(decompressed_size);
+	}
+	int result = Compression::decompress(decompress_buffer.ptr(), decompressed_size, &buf[12], p_buffer.size() - 12, Compression::MODE_ZSTD);
+	ERR_FAIL_COND_V(result != (int)decompressed_size, ERR_INVALID_DATA);
+	r_contents = Span<uint8_t>(decompress_buffer.ptr(), decompressed_size);
+	return OK;
+}
+
+void GDScriptDecomp::decode_identifier_utf32(const uint8_t *p_src, uint32_t p_len, String &r_str) {
+	r_str = String();
+	if (p_len == 0) {
+		return;
+	}
+	// Decode straight into the string's storage, then validate the code points like String::utf32 would.
+	r_str.resize_uninitialized(p_len + 1);
+	char32_t *dst = r_str.ptrw();
+	_xor_decode(reinterpret_cast<uint8_t *>(dst), p_src, p_len * 4);
+	uint32_t len = p_len;
+	for (uint32_t i = 0; i < p_len; i++) {
+#ifdef BIG_ENDIAN_ENABLED
+		dst[i] = BSWAP32(dst[i]);
+#endif
+		const char32_t c = dst[i];
+		if (unlikely(c == 0)) {
+			len = i;
+			break;
+		}
+		if (unlikely((c & 0xfffff800) == 0xd800 || c > 0x10ffff)) {
+			dst[i] = 0xfffd;
+		}
+	}
+	if (unlikely(len == 0)) {
+		r_str = String();
+		return;
+	}
+	if (unlikely(len != p_len)) {
+		r_str.resize_uninitialized(len + 1);
+		dst = r_str.ptrw();
+	}
+	dst[len] = 0;
+}
+
+void GDScriptDecomp::decode_identifier_utf8(const uint8_t *p_src, uint32_t p_len, String &r_str) {
+	r_str = String();
+	if (p_len == 0) {
+		return;
+	}
+	thread_local LocalVector<char> utf8_buffer;
+	if (utf8_buffer.size() < p_len) {
+		utf8_buffer.resize(p_len);
+	}
+	char *dst = utf8_buffer.ptr();
+	_xor_decode(reinterpret_cast<uint8_t *>(dst), p_src, p_len);
+	// The last byte is the null terminator.
+	r_str.append_utf8(dst, strnlen(dst, p_len - 1));
+}
+
 #define GDSC_HEADER "GDSC"
 #define CHECK_GDSC_HEADER(p_buffer) _GDRE_CHECK_HEADER(p_buffer, GDSC_HEADER)
 
@@ -185,15 +301,14 @@ Error GDScriptDecomp::get_ids_consts_tokens_v2(const Vector<uint8_t> &p_buffer,
 	GDSDECOMP_FAIL_COND_V_MSG(version > LATEST_GDSCRIPT_VERSION, ERR_INVALID_DATA, "Binary GDScript is too recent! Please use a newer engine version.");
 	GDSDECOMP_FAIL_COND_V_MSG(version < GDSCRIPT_2_0_VERSION, ERR_INVALID_DATA, "Don't use this function for older versions of GDScript.");
 
-	int decompressed_size = decode_uint32(&buf[8]);
+	Span<uint8_t> contents;
+	GDSDECOMP_FAIL_COND_V_MSG(get_tokenizer_contents(p_buffer, contents) != OK, ERR_INVALID_DATA, "Error decompressing GDScript tokenizer buffer.");
 
-	Vector<uint8_t> contents;
-	GDSDECOMP_FAIL_COND_V_MSG(decompress_buf(p_buffer, contents) != decompressed_size, ERR_INVALID_DATA, "Error decompressing GDScript tokenizer buffer.");
-
-	int total_len = contents.size();
+	int total_len = (int)contents.size();
 	buf = contents.ptr();
 	const int token_count_offset = version < CONTENT_HEADER_SIZE_CHANGED ? 16 : 12;
 	const int content_header_size = token_count_offset + 4;
+	GDSDECOMP_FAIL_COND_V_MSG(total_len < content_header_size, ERR_INVALID_DATA, "Invalid GDScript tokenizer buffer.");
 	uint32_t identifier_count = decode_uint32(&buf[0]);
 	uint32_t constant_count = decode_uint32(&buf[4]);
 	uint32_t token_line_count = decode_uint32(&buf[8]);
@@ -208,16 +323,8 @@ Error GDScriptDecomp::get_ids_consts_tokens_v2(const Vector<uint8_t> &p_buffer,
 		total_len -= 4;
 		GDSDECOMP_FAIL_COND_V_MSG((len * 4u) > (uint32_t)total_len, ERR_INVALID_DATA, "Invalid identifier length.");
 		b += 4;
-		Vector<uint32_t> cs;
-		cs.resize(len);
-		for (uint32_t j = 0; j < len; j++) {
-			uint8_t tmp[4];
-			for (uint32_t k = 0; k < 4; k++) {
-				tmp[k] = b[j * 4 + k] ^ 0xb6;
-			}
-			cs.write[j] = decode_uint32(tmp);
-		}
-		String s = String::utf32({ reinterpret_cast<const char32_t *>(cs.ptr()), len });
+		String s;
+		decode_identifier_utf32(b, len, s);
 		b += len * 4;
 		total_len -= len * 4;
 		identifiers.write[i] = StringName(s);
@@ -319,15 +426,8 @@ Error GDScriptDecomp::get_ids_consts_tokens(const Vector<uint8_t> &p_buffer, Vec
 		uint32_t len = decode_uint32(b);
 		GDSDECOMP_FAIL_COND_V_MSG(len > total_len, ERR_INVALID_DATA, "Invalid identifier length.");
 		b += 4;
-		Vector<uint8_t> cs;
-		cs.resize(len);
-		for (uint32_t j = 0; j < len; j++) {
-			cs.write[j] = b[j] ^ 0xb6;
-		}
-
-		cs.write[cs.size() - 1] = 0;
 		String s;
-		s.append_utf8((const char *)cs.ptr());
+		decode_identifier_utf8(b, len, s);
 		b += len;
 		total_len -= len + 4;
 		identifiers.write[i] = s;
@@ -376,6 +476,29 @@ Error GDScriptDecomp::get_ids_consts_tokens(const Vector<uint8_t> &p_buffer, Vec
 	return OK;
 }
 
+String GDScriptDecomp::get_function_name(int p_func) const {
+	if (p_func < 0 || p_func >= tables->function_count) {
+		return "";
+	}
+	return tables->functions[p_func].name;
+}
+
+Pair<int, int> GDScriptDecomp::get_function_arg_count(int p_func) const {
+	if (p_func < 0 || p_func >= tables->function_count) {
+		return Pair<int, int>(-1, -1);
+	}
+	return Pair<int, int>(tables->functions[p_func].min_args, tables->functions[p_func].max_args);
+}
+
+int GDScriptDecomp::get_function_index(const String &p_func) const {
+	for (int i = 0; i < tables->function_count; i++) {
+		if (p_func == tables->functions[i].name) {
+			return i;
+		}
+	}
+	return -1;
+}
+
 Ref<GDScriptDecomp> GDScriptDecomp::create_decomp_for_commit(uint64_t p_commit_hash) {
 	return Ref<GDScriptDecomp>(::create_decomp_for_commit(p_commit_hash));
 }
@@ -596,6 +719,69 @@ Error GDScriptDecomp::debug_print(Vector<uint8_t> p_buffer) {
 	return OK;
 }
 
+namespace {
+// Append-only UTF-32 buffer used by decompile_buffer(); the script is only materialized into a String once,
+// instead of copying the growing script on every concatenation.
+class ScriptTextBuilder {
+	LocalVector<char32_t> buffer;
+
+public:
+	_FORCE_INLINE_ void reserve(uint32_t p_size) { buffer.reserve(p_size); }
+	_FORCE_INLINE_ uint32_t size() const { return buffer.size(); }
+	_FORCE_INLINE_ bool is_empty() const { return buffer.is_empty(); }
+	_FORCE_INLINE_ void clear() { buffer.clear(); }
+	_FORCE_INLINE_ bool ends_with(char32_t p_char) const { return !buffer.is_empty() && buffer[buffer.size() - 1] == p_char; }
+
+	// True if the buffer only contains whitespace; matches gdre::remove_whitespace(...).is_empty().
+	bool is_blank() const {
+		for (uint32_t i = 0; i < buffer.size(); i++) {
+			const char32_t c = buffer[i];
+			if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void append(const char32_t *p_str, uint32_t p_len) {
+		if (p_len == 0) {
+			return;
+		}
+		const uint32_t pos = buffer.size();
+		buffer.resize(pos + p_len);
+		memcpy(buffer.ptr() + pos, p_str, p_len * sizeof(char32_t));
+	}
+
+	ScriptTextBuilder &operator+=(const String &p_str) {
+		append(p_str.ptr(), p_str.length());
+		return *this;
+	}
+	ScriptTextBuilder &operator+=(const ScriptTextBuilder &p_other) {
+		append(p_other.buffer.ptr(), p_other.buffer.size());
+		return *this;
+	}
+	// ASCII literals only.
+	ScriptTextBuilder &operator+=(const char *p_str) {
+		while (*p_str) {
+			buffer.push_back((uint8_t)*p_str++);
+		}
+		return *this;
+	}
+
+	String as_string() const {
+		String ret;
+		if (buffer.is_empty()) {
+			return ret;
+		}
+		ret.resize_uninitialized(buffer.size() + 1);
+		char32_t *dst = ret.ptrw();
+		memcpy(dst, buffer.ptr(), buffer.size() * sizeof(char32_t));
+		dst[buffer.size()] = 0;
+		return ret;
+	}
+};
+} // namespace
+
 Error GDScriptDecomp::decompile_buffer(Vector<uint8_t> p_buffer) {
 #if 0
 	debug_print(p_buffer);
@@ -620,7 +806,11 @@ Error GDScriptDecomp::decompile_buffer(Vector<uint8_t> p_buffer) {
 	GDSDECOMP_FAIL_COND_V(version != get_bytecode_version(), ERR_INVALID_DATA);
 
 	//Decompile script
-	String line;
+	// Rough estimate of the output size to avoid most reallocations; identifiers and constants are usually longer than a single char.
+	ScriptTextBuilder script;
+	script.reserve(tokens.size() * 6 + 64);
+	ScriptTextBuilder line;
+	line.reserve(256);
 	int indent = 0;
 
 	GlobalToken prev_token = G_TK_NEWLINE;
@@ -638,25 +828,25 @@ Error GDScriptDecomp::decompile_buffer(Vector<uint8_t> p_buffer) {
 		auto curr_line = state.get_token_line(i);
 		auto curr_column = state.get_token_column(i);
 		for (int j = 0; j < indent; j++) {
-			script_text += use_spaces ? " " : "\t";
+			script += use_spaces ? " " : "\t";
 		}
-		script_text += line;
+		script += line;
 		if (curr_line <= prev_line) {
 			curr_line = prev_line + 1; // force new line
 		}
 		while (curr_line > prev_line) {
 			if (curr_token != G_TK_NEWLINE && bytecode_version < GDSCRIPT_2_0_VERSION) {
-				script_text += "\\"; // line continuation
+				script += "\\"; // line continuation
 			} else if (bytecode_version >= GDSCRIPT_2_0_VERSION && !lines.has(i)) {
-				if (!first_line || (!gdre::remove_whitespace(line).is_empty())) {
-					script_text += "\\";
+				if (!first_line || !line.is_blank()) {
+					script += "\\";
 				}
 			}
-			script_text += "\n";
+			script += "\n";
 			prev_line++;
 		}
 		first_line = false;
-		line = String();
+		line.clear();
 		if (curr_token == G_TK_NEWLINE) {
 			indent = tokens[i] >> TOKEN_BITS;
 		} else if (bytecode_version >= GDSCRIPT_2_0_VERSION) {
@@ -684,14 +874,14 @@ Error GDScriptDecomp::decompile_buffer(Vector<uint8_t> p_buffer) {
 	};
 
 	auto ensure_space_func = [&]() {
-		if (!line.ends_with(" ") && prev_token != G_TK_NEWLINE) {
+		if (!line.ends_with(' ') && prev_token != G_TK_NEWLINE) {
 			line += " ";
 		}
 	};
 
 	auto ensure_ending_space_func([&](int idx, GlobalToken check_tk = G_TK_NEWLINE) {
 		if (
-				!line.ends_with(" ") && idx < tokens.size() - 1 &&
+				!line.ends_with(' ') && idx < tokens.size() - 1 &&
 				(get_global_token(tokens[idx + 1]) != G_TK_NEWLINE &&
 						!check_new_line(idx + 1)) &&
 				(check_tk == G_TK_NEWLINE || get_global_token(tokens[idx + 1]) != check_tk)) {
@@ -945,7 +1135,7 @@ Error GDScriptDecomp::decompile_buffer(Vector<uint8_t> p_buffer) {
 				line += "const ";
 			} break;
 			case G_TK_PR_VAR: {
-				if (line != String() && prev_token != G_TK_PR_ONREADY) {
+				if (!line.is_empty() && prev_token != G_TK_PR_ONREADY) {
 					line += " ";
 				}
 				line += "var ";
@@ -1154,17 +1344,18 @@ Error GDScriptDecomp::decompile_buffer(Vector<uint8_t> p_buffer) {
 
 	if (!line.is_empty()) {
 		for (int j = 0; j < indent; j++) {
-			script_text += use_spaces ? " " : "\t";
+			script += use_spaces ? " " : "\t";
 		}
-		script_text += line;
+		script += line;
 	}
 
 	// GDScript 2.0 can have parsing errors if the script does not end with a newline
-	if (bytecode_version >= GDSCRIPT_2_0_VERSION && !script_text.ends_with("\n")) {
-		script_text += "\n";
+	if (bytecode_version >= GDSCRIPT_2_0_VERSION && !script.ends_with('\n')) {
+		script += "\n";
 	}
 
-	if (script_text == String()) {
+	script_text = script.as_string();
+	if (script_text.is_empty()) {
 		if (identifiers.size() == 0 && constants.size() == 0 && tokens.size() == 0) {
 			return OK;
 		}
@@ -8,6 +8,7 @@
 #include "core/object/object.h"
 #include "core/object/ref_counted.h"
 #include "core/templates/hash_map.h"
+#include "core/templates/span.h"
 
 class FakeGDScript;
 
@@ -165,6 +166,21 @@ public:
 		TOKEN_LINE_MASK = (1 << TOKEN_LINE_BITS) - 1,
 	};
 
+	struct FunctionInfo {
+		const char *name;
+		int min_args;
+		int max_args;
+	};
+
+	// Constant lookup tables generated by `bytecode_generator.py` for each bytecode revision.
+	struct BytecodeTables {
+		const GlobalToken *global_tokens; // local token -> global token, `token_max` entries
+		const int16_t *local_tokens; // global token -> local token (-1 if absent), `G_TK_MAX + 1` entries
+		int token_max;
+		const FunctionInfo *functions;
+		int function_count;
+	};
+
 	// bytecode_version, ids,  constants, tokens, lines, columns
 	struct ScriptState {
 		int bytecode_version = -1;
@@ -192,6 +208,8 @@ public:
 	};
 
 protected:
+	const BytecodeTables *tables = nullptr;
+
 	virtual Vector<GlobalToken>
 	get_added_tokens() const {
 		return {};
@@ -211,6 +229,7 @@ protected:
 	Error get_ids_consts_tokens_v2(const Vector<uint8_t> &p_buffer, Vector<StringName> &r_identifiers, Vector<Variant> &r_constants, Vector<uint32_t> &r_tokens, HashMap<uint32_t, uint32_t> &lines, HashMap<uint32_t, uint32_t> &end_lines, HashMap<uint32_t, uint32_t> &columns);
 
 	static Vector<uint8_t> _get_buffer_encrypted(const String &p_path, int engine_ver_major, Vector<uint8_t> p_key);
+	static Error _decrypt_buffer(const String &p_path, int engine_ver_major, const Vector<uint8_t> &p_key, Vector<uint8_t> &r_buffer);
 
 public:
 	static Vector<String> get_bytecode_versions();
@@ -219,13 +238,25 @@ public:
 	virtual BytecodeTestResult _test_bytecode(Vector<uint8_t> p_buffer, int &p_token_max, int &p_func_max, bool print_verbose = false);
 	BytecodeTestResult test_bytecode(Vector<uint8_t> p_buffer, bool print_verbose = false);
 
-	virtual String get_function_name(int p_func) const = 0;
-	virtual int get_function_count() const = 0;
-	virtual Pair<int, int> get_function_arg_count(int p_func) const = 0;
-	virtual int get_token_max() const = 0;
-	virtual int get_function_index(const String &p_func) const = 0;
-	virtual GDScriptDecomp::GlobalToken get_global_token(int p_token) const = 0;
-	virtual int get_local_token_val(GDScriptDecomp::GlobalToken p_token) const = 0;
+	// Token and function lookups are plain table reads; they are called for every token in the hot loops.
+	_FORCE_INLINE_ GlobalToken get_global_token(int p_token) const {
+		p_token &= TOKEN_MASK;
+		if (unlikely(p_token >= tables->token_max)) {
+			return G_TK_MAX;
+		}
+		return tables->global_tokens[p_token];
+	}
+	_FORCE_INLINE_ int get_local_token_val(GlobalToken p_token) const {
+		if (unlikely((int)p_token < 0 || (int)p_token > (int)G_TK_MAX)) {
+			return -1;
+		}
+		return tables->local_tokens[p_token];
+	}
+	_FORCE_INLINE_ int get_token_max() const { return tables->token_max; }
+	_FORCE_INLINE_ int get_function_count() const { return tables->function_count; }
+	String get_function_name(int p_func) const;
+	Pair<int, int> get_function_arg_count(int p_func) const;
+	int get_function_index(const String &p_func) const;
 	virtual int get_bytecode_version() const = 0;
 	virtual int get_bytecode_rev() const = 0;
 	virtual int get_engine_ver_major() const = 0;
@@ -250,6 +281,14 @@ public:
 	static int read_bytecode_version(const String &p_path);
 	static int read_bytecode_version_encrypted(const String &p_path, int engine_ver_major, Vector<uint8_t> p_key);
 	static Error get_buffer_encrypted(const String &p_path, int engine_ver_major, Vector<uint8_t> p_key, Vector<uint8_t> &r_buffer);
+
+	// Returns a view of the tokenizer contents following the 12-byte header of a GDScript 2.0 buffer.
+	// Uncompressed contents point into p_buffer; zstd contents are decompressed into a per-thread buffer,
+	// so the view is only valid until the next call on the same thread.
+	static Error get_tokenizer_contents(const Vector<uint8_t> &p_buffer, Span<uint8_t> &r_contents);
+	// Decode XOR-obfuscated identifiers; UTF-32 for GDScript 2.0 buffers, null-terminated UTF-8 for older ones.
+	static void decode_identifier_utf32(const uint8_t *p_src, uint32_t p_len, String &r_str);
+	static void decode_identifier_utf8(const uint8_t *p_src, uint32_t p_len, String &r_str);
 	String get_script_text();
 	String get_error_message();
 	String get_constant_string(Vector<Variant> &constants, uint32_t constId);
@@ -143,21 +143,14 @@ Error GDScriptV2TokenizerBufferCompat::set_code_buffer(const Vector<uint8_t> &p_
 	int version = decode_uint32(&buf[4]);
 	ERR_FAIL_COND_V_MSG(version > decomp->get_bytecode_version(), ERR_INVALID_DATA, "Binary GDScript is too recent! Please use a newer engine version.");
 
-	int decompressed_size = decode_uint32(&buf[8]);
+	Span<uint8_t> contents;
+	ERR_FAIL_COND_V_MSG(GDScriptDecomp::get_tokenizer_contents(p_buffer, contents) != OK, ERR_INVALID_DATA, "Error decompressing GDScript tokenizer buffer.");
 
-	Vector<uint8_t> contents;
-	if (decompressed_size == 0) {
-		contents = p_buffer.slice(12);
-	} else {
-		contents.resize(decompressed_size);
-		int result = Compression::decompress(contents.ptrw(), contents.size(), &buf[12], p_buffer.size() - 12, Compression::MODE_ZSTD);
-		ERR_FAIL_COND_V_MSG(result != decompressed_size, ERR_INVALID_DATA, "Error decompressing GDScript tokenizer buffer.");
-	}
-
-	int total_len = contents.size();
+	int total_len = (int)contents.size();
 	buf = contents.ptr();
 	const int token_count_offset = version < GDScriptDecomp::CONTENT_HEADER_SIZE_CHANGED ? 16 : 12;
 	const int content_header_size = token_count_offset + 4;
+	ERR_FAIL_COND_V(total_len < content_header_size, ERR_INVALID_DATA);
 	uint32_t identifier_count = decode_uint32(&buf[0]);
 	uint32_t constant_count = decode_uint32(&buf[4]);
 	uint32_t token_line_count = decode_uint32(&buf[8]);
@@ -172,17 +165,8 @@ Error GDScriptV2TokenizerBufferCompat::set_code_buffer(const Vector<uint8_t> &p_
 		total_len -= 4;
 		ERR_FAIL_COND_V((len * 4u) > (uint32_t)total_len, ERR_INVALID_DATA);
 		b += 4;
-		Vector<uint32_t> cs;
-		cs.resize(len);
-		for (uint32_t j = 0; j < len; j++) {
-			uint8_t tmp[4];
-			for (uint32_t k = 0; k < 4; k++) {
-				tmp[k] = b[j * 4 + k] ^ 0xb6;
-			}
-			cs.write[j] = decode_uint32(tmp);
-		}
-
-		String s = String::utf32(Span(reinterpret_cast<const char32_t *>(cs.ptr()), len));
+		String s;
+		GDScriptDecomp::decode_identifier_utf32(b, len, s);
 		b += len * 4;
 		total_len -= len * 4;
 		identifiers.write[i] = s;
@@ -159,25 +159,24 @@ def remove_comments(line: str) -> str:
 
 
 # Now, we need to generate the bytecode file
-# The cpp file will contain the following:
+# The cpp file only contains constant data; all of the lookups are done by GDScriptDecomp through `BytecodeTables`.
+# It will contain the following:
 # 1) the header declarations:
 # ```cpp
 #
 # #include "<file_stem>.h"
 # ```
-# 2) the builtin function declarations, laid out like this:
+# 2) the builtin function table, laid out like this:
 # ```cpp
-# static const Pair<String, Pair<int, int>> funcs[] = {
-# 	{ "sin", Pair<int, int>(1, 1) },
-#   { "cos", Pair<int, int>(1, 1) },
-#   { "tan", Pair<int, int>(1, 1) },
-#   { "sinh", Pair<int, int>(1, 1) },
+# static constexpr GDScriptDecomp::FunctionInfo funcs[] = {
+# 	{ "sin", 1, 1 },
+# 	{ "cos", 1, 1 },
 # 	[etc...]
-# 	{ "is_instance_valid", Pair<int, int>(1, 1) },
+# 	{ "is_instance_valid", 1, 1 },
 # };
-# static constexpr int num_funcs = sizeof(funcs) / sizeof(Pair<String, Pair<int, int>>);
+# static constexpr int num_funcs = sizeof(funcs) / sizeof(funcs[0]);
 # ```
-# We use a Pair here because we need to store the number of arguments for each function
+# We store the minimum and maximum number of arguments for each function
 # we get this by matching the function name with the builtin_func_arg_elements list
 # with special care for the "var2bytes" and "bytes2var" functions, which have a variable number of arguments (1-2) IF the bytecode version is > 3.1
 # 3) the Token enum declarations, like this:
@@ -190,87 +189,66 @@ def remove_comments(line: str) -> str:
 #   TK_MAX
 # };
 # ```
-# 4) the `get_function_name` function, which is laid out like this:
+# 4) the local -> global token table, indexed by the local token value:
 # ```cpp
-# String <class_name>::get_function_name(int p_func) const {
-# 	return funcs[p_func].first;
-# }
-# ```
-# 5) the `get_function_arg_count` function, which is laid out like this:
-# ```cpp
-# Pair<int, int> <class_name>::get_function_arg_count(int p_func) const {
-# 	return funcs[p_func].second;
-# }
-# ```
-# 5.5) the `get_function_index` function, which is laid out like this:
-# ```cpp
-# int <class_name>::get_function_index(const String &p_func) const {
-#   for (int i = 0; i < num_funcs; i++) {
-#     if (funcs[i].first == p_func) {
-#       return i;
-#     }
-#   return -1;
-# }
+# static constexpr GDScriptDecomp::GlobalToken global_tokens[] = {
+# 	GDScriptDecomp::G_TK_EOF, // TK_EOF
+# 	[..etc]
+# };
 # ```
-# 6) the `get_global_token` function, which is laid out like this:
+# 5) the global -> local token table, indexed by the global token value (-1 if the token doesn't exist in this revision):
 # ```cpp
-# GDScriptDecomp::GlobalToken <class_name>::get_global_token(int p_token) const {
-# 	if (p_token < 0 || p_token >= TK_MAX) {
-# 		return GDScriptDecomp::GlobalToken::G_TK_MAX;
-# 	}
-# 	switch(Token(p_token)) {
-# 		case TK_EOF: return GDScriptDecomp::GlobalToken::G_TK_EOF;
-# 		case TK_IDENTIFIER: return GDScriptDecomp::GlobalToken::G_TK_IDENTIFIER;
-# 		case TK_CONSTANT: return GDScriptDecomp::GlobalToken::G_TK_CONSTANT;
-# 		[..etc]
-# 		case TK_MAX: return GDScriptDecomp::GlobalToken::G_TK_MAX;
-# 	}
-# 	return GDScriptDecomp::GlobalToken::G_TK_MAX;
-# }
+# static constexpr int16_t local_tokens[] = {
+# 	TK_EMPTY, // G_TK_EMPTY
+# 	-1, // G_TK_SELF
+# 	[..etc]
+# 	TK_MAX, // G_TK_MAX
+# };
 # ```
-# 7) the `get_local_token_val` function, which is laid out like this:
+# 6) the tables themselves and the constructor that hands them to GDScriptDecomp:
 # ```cpp
-# int <class_name>::get_local_token_val(GDScriptDecomp::GlobalToken p_token) const {
-#   switch(p_token) {
-#     case GDScriptDecomp::GlobalToken::G_TK_EOF: return (int) TK_EOF;
-#     case GDScriptDecomp::GlobalToken::G_TK_IDENTIFIER: return (int) TK_IDENTIFIER;
-#     case GDScriptDecomp::GlobalToken::G_TK_CONSTANT: return (int) TK_CONSTANT;
-#     [..etc]
-#     case GDScriptDecomp::GlobalToken::G_TK_MAX: return (int) TK_MAX;
-#     default: return (int) TK_MAX;
-#   }
-#   return (int) TK_MAX;
+# static constexpr GDScriptDecomp::BytecodeTables bytecode_tables = { global_tokens, local_tokens, TK_MAX, funcs, num_funcs };
+#
+# <class_name>::<class_name>() {
+# 	tables = &bytecode_tables;
 # }
 # ```
 # That's it. We're done.
 
 
-NO_BUILTIN_FUNCTION_BODY = """
-String {0}::get_function_name(int p_func) const {{
-    return "";
-}}
-int {0}::get_function_count() const {{
-    return 0;
-}}
-Pair<int, int> {0}::get_function_arg_count(int p_func) const {{
-    return Pair<int, int>(-1, -1);
-}}
-int {0}::get_function_index(const String &p_func) const {{
-    return -1;
-}}
-"""
-
-
-def generate_class_cpp(dir: Path, bytecode_class: BytecodeClass) -> None:
+def read_global_tokens() -> list[str]:
+    # The global token enum is the source of truth for the global -> local table layout.
+    code = ""
+    with open(our_dir / "bytecode" / "bytecode_base.h", "r") as f:
+        code = f.read()
+    start = code.index("enum GlobalToken {")
+    end = code.index("};", start)
+    global_tokens = []
+    for line in code[start + len("enum GlobalToken {") : end].splitlines():
+        line = remove_comments(line).rstrip(",").strip()
+        if line:
+            global_tokens.append(line)
+    if global_tokens[-1] != "G_TK_MAX":
+        raise Exception("Failed to parse GlobalToken enum from bytecode_base.h")
+    return global_tokens
+
+
+def get_function_arg_count(bytecode_class: BytecodeClass, func_name: str):
+    if func_name == "var2bytes" or func_name == "bytes2var":
+        if bytecode_class.bytecode_rev_num in greater_than_3_1_versions:
+            return (1, 2)
+        return (1, 1)
+    for builtin_func_arg_element in builtin_func_arg_elements:
+        if builtin_func_arg_element[0] == func_name:
+            return builtin_func_arg_element[1]
+    return None
+
+
+def generate_class_cpp(dir: Path, bytecode_class: BytecodeClass, global_token_names: list[str]) -> None:
     file_stem = bytecode_class.file_stem
     class_name = bytecode_class.class_name
     func_names = bytecode_class.func_names
     tk_names = bytecode_class.tk_names
-    bytecode_version = bytecode_class.bytecode_version
-    bytecode_rev = bytecode_class.bytecode_rev
-    bytecode_rev_num = bytecode_class.bytecode_rev_num
-    engine_ver_major = bytecode_class.engine_ver_major
-    variant_ver_major = bytecode_class.variant_ver_major
     new_dir = dir
     # ensure the directory exists
     if not new_dir.exists():
@@ -283,31 +261,17 @@ def generate_class_cpp(dir: Path, bytecode_class: BytecodeClass) -> None:
         f.write('#include "' + file_stem + '.h"\n')
         f.write("\n")
 
-        # 2) the builtin function declarations:
+        # 2) the builtin function table:
         if len(func_names) != 0:
-            f.write("static const Pair<String, Pair<int, int>> funcs[] = {\n")
+            f.write("static constexpr GDScriptDecomp::FunctionInfo funcs[] = {\n")
             for func_name in func_names:
-                if func_name == "var2bytes" or func_name == "bytes2var":
-                    if bytecode_rev_num in greater_than_3_1_versions:
-                        f.write('\t{ "' + func_name + '", Pair<int, int>(1, 2) },\n')
-                    else:
-                        f.write('\t{ "' + func_name + '", Pair<int, int>(1, 1) },\n')
-                else:
-                    for builtin_func_arg_element in builtin_func_arg_elements:
-                        if builtin_func_arg_element[0] == func_name:
-                            f.write(
-                                '\t{ "'
-                                + func_name
-                                + '", Pair<int, int>('
-                                + str(builtin_func_arg_element[1][0])
-                                + ", "
-                                + str(builtin_func_arg_element[1][1])
-                                + ") },\n"
-                            )
-                            break
+                arg_count = get_function_arg_count(bytecode_class, func_name)
+                if arg_count is None:
+                    continue
+                f.write('\t{ "' + func_name + '", ' + str(arg_count[0]) + ", " + str(arg_count[1]) + " },\n")
             f.write("};\n")
             f.write("\n")
-            f.write("static constexpr int num_funcs = sizeof(funcs) / sizeof(Pair<String, Pair<int, int>>);\n")
+            f.write("static constexpr int num_funcs = sizeof(funcs) / sizeof(funcs[0]);\n")
         # 3) the Token enum declarations:
         f.write("enum Token {\n")
         for tk_name in tk_names:
@@ -315,80 +279,44 @@ def generate_class_cpp(dir: Path, bytecode_class: BytecodeClass) -> None:
         f.write("};\n")
         f.write("\n")
 
-        # 3.5) the `get_token_max` function:
-        f.write("int " + class_name + "::get_token_max() const {\n")
-        f.write("\treturn TK_MAX;\n")
-        f.write("}\n")
-
-        if len(func_names) == 0:
-            f.write(NO_BUILTIN_FUNCTION_BODY.format(class_name))
-        else:
-            # 4) the `get_function_name` function:
-            f.write("String " + class_name + "::get_function_name(int p_func) const {\n")
-            f.write("\tif (p_func < 0 || p_func >= num_funcs) {\n")
-            f.write('\t\treturn "";\n')
-            f.write("\t}\n")
-            f.write("\treturn funcs[p_func].first;\n")
-            f.write("}\n")
-            f.write("\n")
-
-            # 4.5) the `get_function_count` function:
-            f.write("int " + class_name + "::get_function_count() const {\n")
-            f.write("\treturn num_funcs;\n")
-            f.write("}\n")
-
-            # 5) the `get_function_arg_count` function:
-            f.write("Pair<int, int> " + class_name + "::get_function_arg_count(int p_func) const {\n")
-            f.write("\tif (p_func < 0 || p_func >= num_funcs) {\n")
-            f.write("\t\treturn Pair<int, int>(-1, -1);\n")
-            f.write("\t}\n")
-            f.write("\treturn funcs[p_func].second;\n")
-            f.write("}\n")
-            f.write("\n")
-
-            f.write("\n")
-            # 5.5) the `get_function_index` function:
-            f.write("int " + class_name + "::get_function_index(const String &p_func) const {\n")
-            f.write("\tfor (int i = 0; i < num_funcs; i++) {\n")
-            f.write("\t\tif (funcs[i].first == p_func) {\n")
-            f.write("\t\t\treturn i;\n")
-            f.write("\t\t}\n")
-            f.write("\t}\n")
-            f.write("\treturn -1;\n")
-            f.write("}\n")
-            f.write("\n")
-
-        # 6) the `get_global_token` function:
-        f.write("GDScriptDecomp::GlobalToken " + class_name + "::get_global_token(int p_token) const {\n")
-        f.write("\tp_token = p_token & TOKEN_MASK;\n")
-        f.write("\tif (p_token < 0 || p_token >= TK_MAX) {\n")
-        f.write("\t\treturn GDScriptDecomp::GlobalToken::G_TK_MAX;\n")
-        f.write("\t}\n")
-        f.write("\tswitch(Token(p_token)) {\n")
+        # 4) the local -> global token table:
+        f.write("static constexpr GDScriptDecomp::GlobalToken global_tokens[] = {\n")
         for tk_name in tk_names:
-            f.write("\t\tcase " + tk_name + ": return GDScriptDecomp::GlobalToken::G_" + tk_name + ";\n")
-        f.write("\t\tdefault: return GDScriptDecomp::GlobalToken::G_TK_MAX;\n")
-        f.write("\t}\n")
-        f.write("\treturn GDScriptDecomp::GlobalToken::G_TK_MAX;\n")
-        f.write("}\n")
+            if tk_name == "TK_MAX":
+                continue
+            f.write("\tGDScriptDecomp::G_" + tk_name + ", // " + tk_name + "\n")
+        f.write("};\n")
+        f.write("static_assert(sizeof(global_tokens) / sizeof(global_tokens[0]) == TK_MAX);\n")
         f.write("\n")
 
-        # 7) the `get_local_token_val` function:
-        f.write("int " + class_name + "::get_local_token_val(GDScriptDecomp::GlobalToken p_token) const {\n")
-        f.write("\tswitch(p_token) {\n")
-        for tk_name in tk_names:
-            f.write("\t\tcase GDScriptDecomp::GlobalToken::G_" + tk_name + ": return (int) " + tk_name + ";\n")
-        f.write("\t\tdefault: return -1;\n")
-        f.write("\t}\n")
-        f.write("\treturn -1;\n")
-        f.write("}\n")
+        # 5) the global -> local token table:
+        f.write("static constexpr int16_t local_tokens[] = {\n")
+        for global_token_name in global_token_names:
+            local_name = global_token_name[2:]
+            if local_name in tk_names:
+                f.write("\t" + local_name + ", // " + global_token_name + "\n")
+            else:
+                f.write("\t-1, // " + global_token_name + "\n")
+        f.write("};\n")
+        f.write("static_assert(sizeof(local_tokens) / sizeof(local_tokens[0]) == GDScriptDecomp::G_TK_MAX + 1);\n")
         f.write("\n")
 
-        # 8) the `test_bytecode` function:
-        # f.write("GDScriptDecomp::BYTECODE_TEST_RESULT " + class_name + "::test_bytecode(Vector<uint8_t> buffer) {\n")
-        # f.write("\treturn GDScriptDecomp::test_bytecode(buffer);\n")
-        # f.write("}\n")
-        # f.write("\n")
+        # 6) the tables and the constructor:
+        f.write("static constexpr GDScriptDecomp::BytecodeTables bytecode_tables = {\n")
+        f.write("\tglobal_tokens,\n")
+        f.write("\tlocal_tokens,\n")
+        f.write("\tTK_MAX,\n")
+        if len(func_names) != 0:
+            f.write("\tfuncs,\n")
+            f.write("\tnum_funcs,\n")
+        else:
+            f.write("\tnullptr,\n")
+            f.write("\t0,\n")
+        f.write("};\n")
+        f.write("\n")
+        f.write(class_name + "::" + class_name + "() {\n")
+        f.write("\ttables = &bytecode_tables;\n")
+        f.write("}\n")
 
 
 # The class header files will look like this:
@@ -413,14 +341,6 @@ def generate_class_cpp(dir: Path, bytecode_class: BytecodeClass) -> None:
 # 	virtual Vector<String> get_function_arg_count_changed() const { return {<arg_count_changed>}; }
 #
 # public:
-# 	virtual String get_function_name(int p_func) const override;
-#   virtual int get_token_max() const override;
-# 	virtual int get_function_count() const override;
-# 	virtual Pair<int, int> get_function_arg_count(int p_func) const override;
-#   virtual int get_function_index(const String &p_func) const override;
-# 	virtual GDScriptDecomp::GlobalToken get_global_token(int p_token) const override;
-# 	virtual int get_local_token_val(GDScriptDecomp::GlobalToken p_token) const override;
-# 	virtual BYTECODE_TEST_RESULT test_bytecode(Vector<uint8_t> buffer) override;
 # 	virtual int get_bytecode_version() const override { return bytecode_version; }
 # 	virtual int get_bytecode_rev() const override { return bytecode_rev; }
 # 	virtual int get_engine_ver_major() const override { return engine_ver_major; }
@@ -430,7 +350,7 @@ def generate_class_cpp(dir: Path, bytecode_class: BytecodeClass) -> None:
 # 	virtual String get_max_engine_version() const override { return max_engine_version; }
 
 
-# 	<class_name>() {}
+# 	<class_name>(); // sets `tables`, see the cpp file
 # };
 # ```
 def generate_class_header(dir: Path, bytecode_class: BytecodeClass) -> None:
@@ -504,13 +424,6 @@ def generate_class_header(dir: Path, bytecode_class: BytecodeClass) -> None:
                 + '"}; }\n'
             )
         f.write("public:\n")
-        f.write("\tvirtual String get_function_name(int p_func) const override;\n")
-        f.write("\tvirtual int get_function_count() const override;\n")
-        f.write("\tvirtual Pair<int, int> get_function_arg_count(int p_func) const override;\n")
-        f.write("\tvirtual int get_token_max() const override;\n")
-        f.write("\tvirtual int get_function_index(const String &p_func) const override;\n")
-        f.write("\tvirtual GDScriptDecomp::GlobalToken get_global_token(int p_token) const override;\n")
-        f.write("\tvirtual int get_local_token_val(GDScriptDecomp::GlobalToken p_token) const override;\n")
         f.write("\tvirtual int get_bytecode_version() const override { return bytecode_version; }\n")
         f.write("\tvirtual int get_bytecode_rev() const override { return bytecode_rev; }\n")
         f.write("\tvirtual int get_engine_ver_major() const override { return engine_ver_major; }\n")
@@ -519,7 +432,7 @@ def generate_class_header(dir: Path, bytecode_class: BytecodeClass) -> None:
         f.write("\tvirtual String get_engine_version() const override { return engine_version; }\n")
         f.write("\tvirtual String get_max_engine_version() const override { return max_engine_version; }\n")
 
-        f.write("\t" + class_name + "() {}\n")
+        f.write("\t" + class_name + "();\n")
         f.write("};\n")
         f.write("\n")
 
@@ -761,8 +674,9 @@ json_path = our_dir / "misc" / "bytecode_versions.json"
 bytecode_dir = our_dir / "bytecode"
 
 bytecode_classes = read_bytecode_json(json_path)
+global_token_names = read_global_tokens()
 for bytecode_class in bytecode_classes:
-    generate_class_cpp(bytecode_dir, bytecode_class)
+    generate_class_cpp(bytecode_dir, bytecode_class, global_token_names)
     generate_class_header(bytecode_dir, bytecode_class)
 
 generate_bytecode_version_header(bytecode_dir, bytecode_classes)
@@ -53,15 +53,15 @@ func dump_files(output_dir:String, files: PackedStringArray, ignore_checksum_err
 	var err:int = OK;
 	var pckdump = PckDumper.new()
 	# var start_time = Time.get_ticks_msec()
-	err = pckdump.check_md5_all_files()
-	if err != OK:
-		if (err != ERR_SKIP and not ignore_checksum_errors):
+	# Checksums are verified while extracting, so the pack is only read once.
+	err = pckdump.pck_dump_to_dir(output_dir, files, true)
+	if err == ERR_FILE_CORRUPT:
+		if (not ignore_checksum_errors):
 			print("MD5 checksum failed, not proceeding...")
 			return err
-		elif (ignore_checksum_errors):
-			print("MD5 checksum failed, but --ignore_checksum_errors specified, proceeding anyway...")
-	err = pckdump.pck_dump_to_dir(output_dir, files)
-	if err != OK:
+		print("MD5 checksum failed, but --ignore_checksum_errors specified, proceeding anyway...")
+		err = OK
+	elif err != OK:
 		print("error dumping to dir")
 	# var end_time = Time.get_ticks_msec()
 	# var secs_taken = (end_time - start_time) / 1000
@@ -92,6 +92,10 @@ var EXTRACT_TRANSLATION_NOTES = """Extract Translations Options:
 var REPLACE_TRANSLATION_NOTES = """Replace Translations Options:
 --translation-csv=<SRC_FILE>=<DEST_FILE>    The csv file to replace/add the translation (e.g. "/path/to/file.csv=res://file.csv") (can be repeated)
 --patch-file=<SRC_FILE>=<DEST_FILE>      	The file to patch the PCK with (e.g. "/path/to/file.ttf=res://file.ttf") (can be repeated)
+--patch-pck-only                         	Write a separate patch PCK with only the replaced and added files to --output,
+										  for games that load additional packs, instead of rebuilding the whole PCK
+--patch-in-place                         	Append the changes to the PCK itself instead of rewriting it
+										  (standalone PCK format v3 or later only; --output defaults to the source PCK)
 """
 
 func print_usage():
@@ -321,6 +325,8 @@ func handle_cli(args: PackedStringArray) -> int:
 	var main_cmds = {}
 	var replace_translation_pck: String = ""
 	var translation_map: Dictionary[String, String] = {}
+	var patch_pck_only: bool = false
+	var patch_in_place: bool = false
 	var ret: int = OK
 	if (args.size() == 0):
 		print_usage()
@@ -379,6 +385,10 @@ func handle_cli(args: PackedStringArray) -> int:
 				print("ERROR: old translation csv does not exist: " + fpath)
 				return 2
 			GDRESettings.add_old_translation_csv_path(fpath)
+		elif arg == "--patch-pck-only":
+			patch_pck_only = true
+		elif arg == "--patch-in-place":
+			patch_in_place = true
 		elif arg.begins_with("--patch-file"):
 			var parsed_arg = get_arg_value(arg)
 			var patch_files = parsed_arg.split("=", false, 2)
@@ -445,7 +455,13 @@ func handle_cli(args: PackedStringArray) -> int:
 
 		patch_map.merge(add_patch_map)
 
-		ret = patch_pck(replace_translation_pck, output_dir, patch_map)
+		if patch_in_place:
+			if patch_pck_only:
+				print("ERROR: --patch-in-place can't be combined with --patch-pck-only")
+				return 2
+			if output_dir.is_empty():
+				output_dir = replace_translation_pck
+		ret = patch_pck(replace_translation_pck, output_dir, patch_map, "", patch_pck_only, patch_in_place)
 		GDRESettings.unload_project()
 	else:
 		print_usage()
@@ -490,7 +506,9 @@ func _start_patch_pck(dest_pck: String, pack_info: PackInfo, embed_pck: String =
 							embed_pck)
 	return pck_creator
 
-func patch_pck(src_file: String, dest_pck:String, patch_file_map: Dictionary, embed_pck: String = "") -> int:
+# With patch_only, dest_pck only gets the files in patch_file_map, in the source pack's format and version.
+# With in_place, a dest_pck that is the source pack gets the changes appended rather than being rewritten.
+func patch_pck(src_file: String, dest_pck:String, patch_file_map: Dictionary, embed_pck: String = "", patch_only: bool = false, in_place: bool = false) -> int:
 	if (src_file.is_empty()):
 		print_usage()
 		print("Error: --pck-patch is required")
@@ -500,9 +518,14 @@ func patch_pck(src_file: String, dest_pck:String, patch_file_map: Dictionary, em
 		print("Error: --output is required")
 		return 4
 	src_file = get_cli_abs_path(src_file)
+	# PckCreator matches entries to reuse against the loaded pack's absolute path.
+	dest_pck = get_cli_abs_path(dest_pck)
 	if (not FileAccess.file_exists(src_file)):
 		print("Error: PCK file '" + src_file + "' does not exist")
 		return 4
+	if (patch_only and dest_pck == src_file):
+		print("Error: the patch PCK can't overwrite the source PCK")
+		return 4
 	var existing_pck_files = load_pck([src_file], true)
 	if (existing_pck_files.size() == 0):
 		print("Error: failed to load PCK file")
@@ -522,14 +545,19 @@ func patch_pck(src_file: String, dest_pck:String, patch_file_map: Dictionary, em
 	var reverse_map:Dictionary[String, String] = {}
 	for key in patch_file_map.keys():
 		reverse_map[patch_file_map[key]] = key
-	for pck_file in existing_pck_files:
+	# Untouched entries are copied from the source pack as stored, without decrypting and re-encrypting them.
+	var unchanged_file_map:Dictionary[String, String] = {}
+	for pck_file in ([] if patch_only else existing_pck_files):
 		if (reverse_map.has(pck_file) or reverse_map.has(pck_file.trim_prefix("res://"))):
 			continue
 		if (pck_file.is_relative_path()):
 			pck_file = "res://" + pck_file
-		patch_file_map[pck_file] = pck_file
+		unchanged_file_map[pck_file] = pck_file
 	var pck_patcher = _start_patch_pck(dest_pck, pack_infos[0], embed_pck)
+	pck_patcher.set_in_place(in_place and dest_pck == src_file)
 	var err = pck_patcher.add_files(patch_file_map)
+	if (err == OK):
+		err = pck_patcher.add_raw_files(unchanged_file_map)
 	if (err != OK):
 		print("Error: failed to add files to patch PCK: " + pck_patcher.get_error_message())
 		return 4
@@ -546,5 +574,8 @@ func patch_pck(src_file: String, dest_pck:String, patch_file_map: Dictionary, em
 	if (err != OK):
 		print("Error: failed to write patching PCK:" + pck_patcher.get_error_message())
 		return 4
-	print("Patched PCK file: " + dest_pck)
+	if patch_only:
+		print("Wrote patch PCK file: " + dest_pck)
+	else:
+		print("Patched PCK file: " + dest_pck)
 	return OK
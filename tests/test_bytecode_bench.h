@@ -0,0 +1,152 @@
+#pragma once
+
+#include "../bytecode/bytecode_base.h"
+#include "bytecode/bytecode_versions.h"
+#include "core/os/os.h"
+#include "test_common.h"
+#include "tests/test_macros.h"
+
+#include <utility/glob.h>
+
+#include <atomic>
+#include <cstdlib>
+
+// Throughput benchmark for the bytecode layer. Skipped by default; run with
+// `--test --test-case="*[Bench]*" --no-skip` to get a per-revision report.
+namespace TestBytecodeBench {
+
+// Allocations made while counting is on. Everything in the engine ends up in malloc/realloc
+// (Memory::alloc_static/realloc_static), so counting at that level sees all of them.
+static std::atomic<bool> counting_allocs{ false };
+static std::atomic<uint64_t> alloc_count{ 0 };
+
+} //namespace TestBytecodeBench
+
+#if defined(__GLIBC__) && !defined(SANITIZERS_ENABLED)
+// glibc allows a program to replace malloc and still exports its own implementation, so these just count and forward.
+extern "C" void *__libc_malloc(size_t p_size);
+extern "C" void *__libc_realloc(void *p_ptr, size_t p_size);
+
+extern "C" void *malloc(size_t p_size) __THROW {
+	if (TestBytecodeBench::counting_allocs.load(std::memory_order_relaxed)) {
+		TestBytecodeBench::alloc_count.fetch_add(1, std::memory_order_relaxed);
+	}
+	return __libc_malloc(p_size);
+}
+
+extern "C" void *realloc(void *p_ptr, size_t p_size) __THROW {
+	if (TestBytecodeBench::counting_allocs.load(std::memory_order_relaxed)) {
+		TestBytecodeBench::alloc_count.fetch_add(1, std::memory_order_relaxed);
+	}
+	return __libc_realloc(p_ptr, p_size);
+}
+#endif
+
+namespace TestBytecodeBench {
+
+static constexpr int BENCH_ITERATIONS = 5;
+
+struct BenchScript {
+	String name;
+	String text;
+};
+
+struct BenchResult {
+	int scripts = 0;
+	uint64_t tokens = 0;
+	uint64_t test_usec = 0;
+	uint64_t state_usec = 0;
+	uint64_t strings_usec = 0;
+	uint64_t decompile_usec = 0;
+	// malloc/realloc calls made by decompile_buffer, over all scripts and iterations.
+	uint64_t decompile_allocs = 0;
+};
+
+inline Vector<BenchScript> load_bench_scripts() {
+	Vector<String> paths = Glob::rglob_list({ get_gdsdecomp_path().path_join("helpers/*.gd"), get_test_resources_path().path_join("**/*.gd") });
+	Vector<BenchScript> scripts;
+	for (const String &path : paths) {
+		Error err;
+		String text = FileAccess::get_file_as_string(path, &err);
+		if (err == OK && !text.is_empty()) {
+			scripts.push_back({ path.get_file().get_basename(), text });
+		}
+	}
+	return scripts;
+}
+
+inline double per_second(uint64_t p_count, uint64_t p_usec) {
+	return p_usec == 0 ? 0.0 : (double)p_count * 1000000.0 / (double)p_usec;
+}
+
+inline BenchResult bench_revision(const Ref<GDScriptDecomp> &p_decomp, const Vector<BenchScript> &p_scripts) {
+	BenchResult res;
+	Vector<Vector<uint8_t>> buffers;
+	for (const BenchScript &script : p_scripts) {
+		Vector<uint8_t> buf = p_decomp->compile_code_string(script.text);
+		// Scripts using syntax this revision doesn't have just fail to compile; leave them out.
+		if (buf.is_empty() || !p_decomp->get_error_message().is_empty()) {
+			continue;
+		}
+		GDScriptDecomp::ScriptState state;
+		if (p_decomp->get_script_state(buf, state) != OK) {
+			continue;
+		}
+		res.tokens += state.tokens.size();
+		buffers.push_back(buf);
+	}
+	res.scripts = buffers.size();
+	res.tokens *= BENCH_ITERATIONS;
+
+	for (int it = 0; it < BENCH_ITERATIONS; it++) {
+		for (const Vector<uint8_t> &buf : buffers) {
+			uint64_t t0 = OS::get_singleton()->get_ticks_usec();
+			p_decomp->test_bytecode(buf, false);
+			uint64_t t1 = OS::get_singleton()->get_ticks_usec();
+			GDScriptDecomp::ScriptState state;
+			p_decomp->get_script_state(buf, state);
+			uint64_t t2 = OS::get_singleton()->get_ticks_usec();
+			Vector<String> strings;
+			Vector<String> identifiers;
+			p_decomp->get_script_strings_from_buf(buf, strings, identifiers);
+			uint64_t allocs_before = alloc_count.load();
+			counting_allocs = true;
+			uint64_t t3 = OS::get_singleton()->get_ticks_usec();
+			p_decomp->decompile_buffer(buf);
+			uint64_t t4 = OS::get_singleton()->get_ticks_usec();
+			counting_allocs = false;
+			res.decompile_allocs += alloc_count.load() - allocs_before;
+			res.test_usec += t1 - t0;
+			res.state_usec += t2 - t1;
+			res.strings_usec += t3 - t2;
+			res.decompile_usec += t4 - t3;
+		}
+	}
+	return res;
+}
+
+TEST_CASE("[GDSDecomp][Bytecode][Bench] Bytecode layer throughput across all revisions" * doctest::skip()) {
+	Vector<BenchScript> scripts = load_bench_scripts();
+	REQUIRE(scripts.size() > 0);
+	print_line(vformat("Benchmarking %d scripts, %d iterations (tokens/sec)", scripts.size(), BENCH_ITERATIONS));
+	print_line("revision  scripts  test_bytecode  get_script_state  get_script_strings  decompile_buffer  allocs/script");
+	for (const GDScriptDecompVersion &ver : get_decomp_versions(true)) {
+		Ref<GDScriptDecomp> decomp = GDScriptDecomp::create_decomp_for_commit(ver.commit);
+		CHECK(decomp.is_valid());
+		if (decomp.is_null()) {
+			continue;
+		}
+		BenchResult res = bench_revision(decomp, scripts);
+		// Allocations are only counted with glibc; elsewhere the column reads 0.
+		int64_t allocs_per_script = res.scripts > 0 ? res.decompile_allocs / (res.scripts * BENCH_ITERATIONS) : 0;
+		print_line(vformat("%07x  %7d  %13.0f  %16.0f  %18.0f  %16.0f  %13d",
+				ver.commit, res.scripts,
+				per_second(res.tokens, res.test_usec),
+				per_second(res.tokens, res.state_usec),
+				per_second(res.tokens, res.strings_usec),
+				per_second(res.tokens, res.decompile_usec),
+				allocs_per_script));
+	}
+}
+
+} //namespace TestBytecodeBench
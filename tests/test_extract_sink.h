@@ -0,0 +1,155 @@
+#pragma once
+
+#include "core/io/dir_access.h"
+#include "core/io/file_access.h"
+#include "modules/zip/zip_reader.h"
+#include "tests/test_common.h"
+#include "tests/test_macros.h"
+#include "utility/extract_sink.h"
+
+namespace TestExtractSink {
+
+inline String get_long_name() {
+	// Over the 100 bytes a plain ustar header can hold.
+	return String("long/").path_join(String("n").repeat(120)) + ".txt";
+}
+
+inline Vector<uint8_t> make_data(int p_len, uint8_t p_seed) {
+	Vector<uint8_t> data;
+	data.resize(p_len);
+	for (int i = 0; i < p_len; i++) {
+		data.write[i] = (uint8_t)(i * 31 + p_seed);
+	}
+	return data;
+}
+
+// Returns the entries of a tar written by ExtractTarSink, resolving GNU long name records.
+inline HashMap<String, Vector<uint8_t>> read_tar(const String &p_path) {
+	HashMap<String, Vector<uint8_t>> files;
+	Vector<uint8_t> tar = FileAccess::get_file_as_bytes(p_path);
+	String long_name;
+	int64_t ofs = 0;
+	while (ofs + 512 <= tar.size()) {
+		const uint8_t *h = tar.ptr() + ofs;
+		if (h[0] == 0) {
+			break;
+		}
+		String name = String::utf8((const char *)h, strnlen((const char *)h, 100));
+		int64_t size = 0;
+		for (int i = 124; i < 135 && h[i] >= '0' && h[i] <= '7'; i++) {
+			size = size * 8 + (h[i] - '0');
+		}
+		char type = h[156];
+		ofs += 512;
+		if (ofs + size > tar.size()) {
+			break;
+		}
+		if (type == 'L') {
+			long_name = String::utf8((const char *)tar.ptr() + ofs, size - 1);
+		} else {
+			files[long_name.is_empty() ? name : long_name] = tar.slice(ofs, ofs + size);
+			long_name = String();
+		}
+		ofs += (size + 511) / 512 * 512;
+	}
+	return files;
+}
+
+TEST_CASE("[GDSDecomp][ExtractSink] zip entries read back with ZIPReader") {
+	String dir = get_tmp_path().path_join("extract_sink_zip");
+	gdre::ensure_dir(dir);
+	String zip_path = dir.path_join("out.zip");
+	Vector<uint8_t> small = make_data(37, 1);
+	Vector<uint8_t> longer = make_data(70000, 2);
+	String long_name = get_long_name();
+
+	Ref<ExtractSink> sink = ExtractSink::create(zip_path);
+	REQUIRE(sink.is_valid());
+	CHECK(!sink->is_directory());
+	CHECK(sink->write_file("small.bin", small.ptr(), small.size()) == OK);
+
+	String src_path = dir.path_join("src.bin");
+	Ref<FileAccess> src = FileAccess::open(src_path, FileAccess::WRITE);
+	REQUIRE(src.is_valid());
+	src->store_buffer(longer.ptr(), longer.size());
+	src.unref();
+	src = FileAccess::open(src_path, FileAccess::READ);
+	REQUIRE(src.is_valid());
+	CHECK(sink->write_file_from(long_name, src, longer.size()) == OK);
+	CHECK(sink->finish() == OK);
+
+	Ref<ZIPReader> zip = memnew(ZIPReader);
+	REQUIRE(zip->open(zip_path) == OK);
+	PackedStringArray names = zip->get_files();
+	CHECK(names.size() == 2);
+	CHECK(names.has("small.bin"));
+	CHECK(names.has(long_name));
+	CHECK(zip->read_file("small.bin") == small);
+	CHECK(zip->read_file(long_name) == longer);
+	zip->close();
+}
+
+TEST_CASE("[GDSDecomp][ExtractSink] zip keeps a consistent directory after a short read") {
+	String dir = get_tmp_path().path_join("extract_sink_zip_short");
+	gdre::ensure_dir(dir);
+	String zip_path = dir.path_join("out.zip");
+	Vector<uint8_t> data = make_data(1000, 3);
+	Vector<uint8_t> after = make_data(10, 4);
+
+	String src_path = dir.path_join("short.bin");
+	Ref<FileAccess> src = FileAccess::open(src_path, FileAccess::WRITE);
+	REQUIRE(src.is_valid());
+	src->store_buffer(data.ptr(), 600);
+	src.unref();
+	src = FileAccess::open(src_path, FileAccess::READ);
+	REQUIRE(src.is_valid());
+
+	Ref<ExtractSink> sink = ExtractSink::create(zip_path);
+	REQUIRE(sink.is_valid());
+	CHECK(sink->write_file_from("short.bin", src, data.size()) == ERR_FILE_CANT_READ);
+	CHECK(sink->write_file("after.bin", after.ptr(), after.size()) == OK);
+	CHECK(sink->finish() == OK);
+
+	// The failed entry is recorded zero-filled to its full length, so the entry after it is still found.
+	Ref<ZIPReader> zip = memnew(ZIPReader);
+	REQUIRE(zip->open(zip_path) == OK);
+	CHECK(zip->get_files().size() == 2);
+	Vector<uint8_t> expected = data.slice(0, 600);
+	expected.resize(data.size());
+	memset(expected.ptrw() + 600, 0, data.size() - 600);
+	CHECK(zip->read_file("short.bin") == expected);
+	CHECK(zip->read_file("after.bin") == after);
+	zip->close();
+}
+
+TEST_CASE("[GDSDecomp][ExtractSink] tar entries read back") {
+	String dir = get_tmp_path().path_join("extract_sink_tar");
+	gdre::ensure_dir(dir);
+	String tar_path = dir.path_join("out.tar");
+	Vector<uint8_t> small = make_data(37, 5);
+	Vector<uint8_t> longer = make_data(70000, 6);
+	String long_name = get_long_name();
+
+	Ref<ExtractSink> sink = ExtractSink::create(tar_path);
+	REQUIRE(sink.is_valid());
+	CHECK(sink->write_file("small.bin", small.ptr(), small.size()) == OK);
+
+	String src_path = dir.path_join("src.bin");
+	Ref<FileAccess> src = FileAccess::open(src_path, FileAccess::WRITE);
+	REQUIRE(src.is_valid());
+	src->store_buffer(longer.ptr(), longer.size());
+	src.unref();
+	src = FileAccess::open(src_path, FileAccess::READ);
+	REQUIRE(src.is_valid());
+	CHECK(sink->write_file_from(long_name, src, longer.size()) == OK);
+	CHECK(sink->finish() == OK);
+
+	HashMap<String, Vector<uint8_t>> files = read_tar(tar_path);
+	CHECK(files.size() == 2);
+	REQUIRE(files.has("small.bin"));
+	REQUIRE(files.has(long_name));
+	CHECK(files["small.bin"] == small);
+	CHECK(files[long_name] == longer);
+}
+
+} //namespace TestExtractSink
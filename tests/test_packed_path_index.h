@@ -0,0 +1,80 @@
+#pragma once
+
+#include "tests/test_common.h"
+#include "tests/test_macros.h"
+#include "utility/glob.h"
+#include "utility/packed_path_index.h"
+
+namespace TestPackedPathIndex {
+
+inline Vector<String> get_fixture_paths() {
+	return {
+		"res://a.gd",
+		"res://b.GD",
+		"res://noext",
+		"res://trailing.",
+		"res://archive.tar.gz",
+		"res://dir/c.gd",
+		"res://dir/.gd",
+		"res://dir.d/noext2",
+		"res://dir.d/d.gdc",
+		"res://scenes/level.tscn",
+		"res://scenes/level.tscn.remap",
+		"res://.hidden",
+	};
+}
+
+// File names of the entries query_files returns, in the order it returns them.
+inline Vector<String> query_names(PackedPathIndex &p_index, const Vector<String> &p_filters) {
+	LocalVector<uint32_t> indices;
+	p_index.query_files(p_filters, indices);
+	Vector<String> names;
+	for (uint32_t idx : indices) {
+		names.push_back(p_index.get_path(p_index.get_entry(idx)).get_file());
+	}
+	return names;
+}
+
+TEST_CASE("[GDSDecomp][PackedPathIndex] query_files matches Glob::fnmatch_list") {
+	PackedPathIndex index;
+	Vector<String> names;
+	for (const String &path : get_fixture_paths()) {
+		index.insert(path, path, false, PackedData::PackedFile(), false);
+		names.push_back(path.get_file());
+	}
+	// Extension globs go through the buckets, the rest through a full scan; both have to agree with a plain match.
+	Vector<Vector<String>> filter_sets = {
+		{ "*.gd" },
+		{ "*.GD" },
+		{ "*." },
+		{ "*" },
+		{ "*.gz" },
+		{ "*.tar.gz" },
+		{ "*.remap" },
+		{ "level.*" },
+		{ "?.gd" },
+		{ "noext*" },
+		{ ".*" },
+		{ "*.gd", "*.gdc" },
+		{ "*.gd", "c.*" },
+		{ "*.none" },
+	};
+	for (const Vector<String> &filters : filter_sets) {
+		Vector<String> expected = Glob::fnmatch_list(names, filters);
+		Vector<String> result = query_names(index, filters);
+		// Both keep insertion order, so the lists have to be identical.
+		CHECK_MESSAGE(result == expected, String(", ").join(filters));
+	}
+}
+
+TEST_CASE("[GDSDecomp][PackedPathIndex] \"*.\" only matches names ending in a dot") {
+	PackedPathIndex index;
+	for (const String &path : get_fixture_paths()) {
+		index.insert(path, path, false, PackedData::PackedFile(), false);
+	}
+	Vector<String> result = query_names(index, { "*." });
+	CHECK(result.size() == 1);
+	CHECK(result.has("trailing."));
+}
+
+} //namespace TestPackedPathIndex
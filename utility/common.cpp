@@ -3,6 +3,7 @@
 #include "compat/variant_decoder_compat.h"
 #include "utility/glob.h"
 
+#include "core/config/project_settings.h"
 #include "core/error/error_list.h"
 #include "core/error/error_macros.h"
 #include "core/io/dir_access.h"
@@ -12,6 +13,16 @@
 #include "core/io/missing_resource.h"
 #include "modules/zip/zip_reader.h"
 
+#ifdef WINDOWS_ENABLED
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined(UNIX_ENABLED)
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 Vector<String> gdre::get_recursive_dir_list(const String &p_dir, const Vector<String> &wildcards, const bool absolute, const String &rel) {
 	Vector<String> ret;
 	Error err;
@@ -102,6 +113,101 @@ Error gdre::ensure_dir(const String &dst_dir) {
 	return err;
 }
 
+Error gdre::copy_file_range_to_file(const String &p_src, uint64_t p_src_offset, uint64_t p_length, const String &p_dst) {
+#ifdef __linux__
+	String src_path = ProjectSettings::get_singleton()->globalize_path(p_src);
+	String dst_path = ProjectSettings::get_singleton()->globalize_path(p_dst);
+	int src_fd = ::open(src_path.utf8().get_data(), O_RDONLY | O_CLOEXEC);
+	if (src_fd < 0) {
+		return ERR_UNAVAILABLE;
+	}
+	int dst_fd = ::open(dst_path.utf8().get_data(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (dst_fd < 0) {
+		::close(src_fd);
+		return ERR_UNAVAILABLE;
+	}
+	// Reserve the space up front so the file isn't fragmented; filesystems without fallocate just skip this.
+	if (p_length > 0) {
+		fallocate(dst_fd, 0, 0, p_length);
+	}
+	Error err = OK;
+	off64_t src_offset = p_src_offset;
+	uint64_t remaining = p_length;
+	while (remaining > 0) {
+		ssize_t copied = copy_file_range(src_fd, &src_offset, dst_fd, nullptr, MIN(remaining, (uint64_t)1 << 30), 0);
+		if (copied < 0 && errno == EINTR) {
+			continue;
+		}
+		if (copied <= 0) {
+			// Unsupported across these filesystems (EXDEV on older kernels, EINVAL/ENOSYS), or a short source.
+			err = ERR_UNAVAILABLE;
+			break;
+		}
+		remaining -= copied;
+	}
+	::close(src_fd);
+	if (::close(dst_fd) != 0 && err == OK) {
+		err = ERR_FILE_CANT_WRITE;
+	}
+	return err;
+#else
+	return ERR_UNAVAILABLE;
+#endif
+}
+
+Error gdre::preallocate_file(const String &p_path, uint64_t p_length) {
+#if defined(UNIX_ENABLED) && !defined(__APPLE__)
+	String os_path = ProjectSettings::get_singleton()->globalize_path(p_path);
+	int fd = ::open(os_path.utf8().get_data(), O_WRONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return ERR_FILE_CANT_OPEN;
+	}
+	struct stat st;
+	int ret = fstat(fd, &st);
+	if (ret == 0 && (uint64_t)st.st_size < p_length) {
+		// Returns the error instead of setting errno; EOPNOTSUPP/EINVAL where the filesystem can't.
+		ret = posix_fallocate(fd, st.st_size, p_length - st.st_size);
+	}
+	::close(fd);
+	return ret == 0 ? OK : ERR_UNAVAILABLE;
+#else
+	return ERR_UNAVAILABLE;
+#endif
+}
+
+Error gdre::sync_file(const String &p_path) {
+	String os_path = ProjectSettings::get_singleton()->globalize_path(p_path);
+#ifdef WINDOWS_ENABLED
+	HANDLE file = CreateFileW((LPCWSTR)os_path.utf16().get_data(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return ERR_FILE_CANT_OPEN;
+	}
+	bool ok = FlushFileBuffers(file);
+	CloseHandle(file);
+	return ok ? OK : ERR_FILE_CANT_WRITE;
+#elif defined(UNIX_ENABLED)
+	int fd = ::open(os_path.utf8().get_data(), O_WRONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return ERR_FILE_CANT_OPEN;
+	}
+#if defined(__APPLE__)
+	// fsync doesn't reach the disk's own cache on macOS.
+	int ret = fcntl(fd, F_FULLFSYNC);
+	if (ret != 0) {
+		ret = fsync(fd);
+	}
+#elif defined(__linux__)
+	int ret = fdatasync(fd);
+#else
+	int ret = fsync(fd);
+#endif
+	::close(fd);
+	return ret == 0 ? OK : ERR_FILE_CANT_WRITE;
+#else
+	return ERR_UNAVAILABLE;
+#endif
+}
+
 bool gdre::check_header(const Vector<uint8_t> &p_buffer, const char *p_expected_header, int p_expected_len) {
 	if (p_buffer.size() < p_expected_len) {
 		return false;
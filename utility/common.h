@@ -15,6 +15,15 @@ bool dir_has_any_matching_wildcards(const String &dir, const Vector<String> &wil
 
 bool check_header(const Vector<uint8_t> &p_buffer, const char *p_expected_header, int p_expected_len);
 Error ensure_dir(const String &dst_dir);
+// Copies a byte range of p_src into a new p_dst inside the kernel (copy_file_range, reflinked where the filesystem
+// supports it). Returns ERR_UNAVAILABLE when the platform or filesystem can't, so the caller can copy it itself.
+Error copy_file_range_to_file(const String &p_src, uint64_t p_src_offset, uint64_t p_length, const String &p_dst);
+// Grows p_path to p_length bytes with the space actually reserved (posix_fallocate). Returns ERR_UNAVAILABLE where
+// that isn't supported; FileAccess::resize only extends the file sparsely.
+Error preallocate_file(const String &p_path, uint64_t p_length);
+// Waits until the written contents of p_path are on stable storage (fdatasync / FlushFileBuffers). FileAccess::flush
+// only hands buffered data to the OS, which may write it out in any order.
+Error sync_file(const String &p_path);
 void get_strings_from_variant(const Variant &p_var, Vector<String> &r_strings, Vector<String> &r_identifiers, const String &engine_version = "");
 Error decompress_image(const Ref<Image> &img);
 String get_md5(const String &dir, bool ignore_code_signature = false);
@@ -0,0 +1,345 @@
+#include "extract_sink.h"
+
+#include "core/os/os.h"
+#include "utility/common.h"
+
+#include <zlib.h>
+
+Ref<ExtractSink> ExtractSink::create(const String &p_output) {
+	String ext = p_output.get_extension().to_lower();
+	if (ext == "tar" || ext == "zip") {
+		Ref<ExtractArchiveSink> sink;
+		if (ext == "tar") {
+			sink = memnew(ExtractTarSink);
+		} else {
+			sink = memnew(ExtractZipSink);
+		}
+		ERR_FAIL_COND_V_MSG(sink->open(p_output) != OK, Ref<ExtractSink>(), "Failed to create archive " + p_output);
+		return sink;
+	}
+	return memnew(ExtractDirSink(p_output));
+}
+
+Error ExtractSink::_stream(Ref<FileAccess> p_dst, Ref<FileAccess> p_src, uint64_t p_len, CryptoCore::MD5Context *r_md5, uint32_t *r_crc) {
+	uint8_t buf[65536];
+	uint64_t remaining = p_len;
+	Error err = OK;
+	while (remaining > 0) {
+		uint64_t want = MIN((uint64_t)sizeof(buf), remaining);
+		uint64_t got = err == OK ? p_src->get_buffer(buf, want) : 0;
+		if (got < want) {
+			memset(buf + got, 0, want - got);
+			err = ERR_FILE_CANT_READ;
+		}
+		if (r_md5) {
+			r_md5->update(buf, got);
+		}
+		if (r_crc) {
+			*r_crc = crc32(*r_crc, buf, want);
+		}
+		if (!p_dst->store_buffer(buf, want)) {
+			return ERR_FILE_CANT_WRITE;
+		}
+		remaining -= want;
+	}
+	if (err == OK) {
+		// Some sources (e.g. streamed decryption) only report a checksum failure once everything has been read.
+		Error src_err = p_src->get_error();
+		if (src_err != OK && src_err != ERR_FILE_EOF) {
+			err = src_err;
+		}
+	}
+	return err;
+}
+
+Error ExtractDirSink::_ensure_dir_cached(const String &p_dir) {
+	{
+		MutexLock lock(dir_cache_mutex);
+		if (created_dirs.has(p_dir)) {
+			return OK;
+		}
+	}
+	Error err = gdre::ensure_dir(p_dir);
+	if (err == OK) {
+		MutexLock lock(dir_cache_mutex);
+		created_dirs.insert(p_dir);
+	}
+	return err;
+}
+
+Error ExtractDirSink::write_file(const String &p_path, const uint8_t *p_data, uint64_t p_len) {
+	String target = get_target_path(p_path);
+	ERR_FAIL_COND_V(_ensure_dir_cached(target.get_base_dir()) != OK, ERR_CANT_CREATE);
+	Ref<FileAccess> fa = FileAccess::open(target, FileAccess::WRITE);
+	if (fa.is_null()) {
+		return ERR_FILE_CANT_WRITE;
+	}
+	// A full disk shows up as a failed store or only once buffered data is flushed.
+	bool stored = fa->store_buffer(p_data, p_len);
+	fa->flush();
+	if (!stored || fa->get_error() != OK) {
+		return ERR_FILE_CANT_WRITE;
+	}
+	return OK;
+}
+
+Error ExtractDirSink::write_file_from(const String &p_path, Ref<FileAccess> p_src, uint64_t p_len, CryptoCore::MD5Context *r_md5) {
+	String target = get_target_path(p_path);
+	ERR_FAIL_COND_V(_ensure_dir_cached(target.get_base_dir()) != OK, ERR_CANT_CREATE);
+	Ref<FileAccess> fa = FileAccess::open(target, FileAccess::WRITE);
+	if (fa.is_null()) {
+		return ERR_FILE_CANT_WRITE;
+	}
+	Error err = _stream(fa, p_src, p_len, r_md5);
+	fa->flush();
+	if (err == OK && fa->get_error() != OK) {
+		err = ERR_FILE_CANT_WRITE;
+	}
+	return err;
+}
+
+Error ExtractDirSink::copy_range(const String &p_path, const String &p_pack, uint64_t p_offset, uint64_t p_len) {
+	String target = get_target_path(p_path);
+	ERR_FAIL_COND_V(_ensure_dir_cached(target.get_base_dir()) != OK, ERR_CANT_CREATE);
+	return gdre::copy_file_range_to_file(p_pack, p_offset, p_len, target);
+}
+
+Error ExtractArchiveSink::open(const String &p_archive_path) {
+	archive_path = p_archive_path;
+	gdre::ensure_dir(p_archive_path.get_base_dir());
+	Error err;
+	out = FileAccess::open(p_archive_path, FileAccess::WRITE, &err);
+	return out.is_valid() ? OK : err;
+}
+
+void ExtractTarSink::_write_header(const CharString &p_name, uint64_t p_size, char p_type) {
+	uint8_t h[512] = {};
+	memcpy(h, p_name.get_data(), MIN(p_name.length(), 100));
+	auto put_octal = [&](int p_ofs, int p_width, uint64_t p_value) {
+		// p_width includes the terminating NUL.
+		CharString digits = String::num_uint64(p_value, 8).lpad(p_width - 1, "0").ascii();
+		memcpy(h + p_ofs, digits.get_data(), p_width - 1);
+	};
+	put_octal(100, 8, 0644);
+	put_octal(108, 8, 0);
+	put_octal(116, 8, 0);
+	if (p_size < (1ULL << 33)) {
+		put_octal(124, 12, p_size);
+	} else {
+		h[124] = 0x80;
+		for (int i = 0; i < 8; i++) {
+			h[135 - i] = (p_size >> (i * 8)) & 0xFF;
+		}
+	}
+	put_octal(136, 12, OS::get_singleton()->get_unix_time());
+	h[156] = p_type;
+	memcpy(h + 257, "ustar", 6);
+	memcpy(h + 263, "00", 2);
+
+	memset(h + 148, ' ', 8);
+	uint32_t checksum = 0;
+	for (int i = 0; i < 512; i++) {
+		checksum += h[i];
+	}
+	put_octal(148, 7, checksum);
+	h[155] = ' ';
+	out->store_buffer(h, 512);
+}
+
+void ExtractTarSink::_pad(uint64_t p_size) {
+	static const uint8_t zeros[512] = {};
+	if (p_size % 512) {
+		out->store_buffer(zeros, 512 - (p_size % 512));
+	}
+}
+
+Error ExtractTarSink::write_file(const String &p_path, const uint8_t *p_data, uint64_t p_len) {
+	CharString name = p_path.utf8();
+	MutexLock lock(write_mutex);
+	if (name.length() > 100) {
+		_write_header("././@LongLink", name.length() + 1, 'L');
+		out->store_buffer((const uint8_t *)name.get_data(), name.length() + 1);
+		_pad(name.length() + 1);
+	}
+	_write_header(name, p_len, '0');
+	out->store_buffer(p_data, p_len);
+	_pad(p_len);
+	if (out->get_error() != OK) {
+		write_failed = true;
+		return ERR_FILE_CANT_WRITE;
+	}
+	return OK;
+}
+
+Error ExtractTarSink::write_file_from(const String &p_path, Ref<FileAccess> p_src, uint64_t p_len, CryptoCore::MD5Context *r_md5) {
+	CharString name = p_path.utf8();
+	MutexLock lock(write_mutex);
+	if (name.length() > 100) {
+		_write_header("././@LongLink", name.length() + 1, 'L');
+		out->store_buffer((const uint8_t *)name.get_data(), name.length() + 1);
+		_pad(name.length() + 1);
+	}
+	_write_header(name, p_len, '0');
+	Error err = _stream(out, p_src, p_len, r_md5);
+	if (err == ERR_FILE_CANT_WRITE) {
+		write_failed = true;
+		return err;
+	}
+	_pad(p_len);
+	return err;
+}
+
+Error ExtractTarSink::finish() {
+	MutexLock lock(write_mutex);
+	ERR_FAIL_COND_V(out.is_null(), ERR_UNCONFIGURED);
+	static const uint8_t zeros[1024] = {};
+	out->store_buffer(zeros, 1024);
+	out->flush();
+	Error err = (out->get_error() == OK && !write_failed) ? OK : ERR_FILE_CANT_WRITE;
+	out.unref();
+	return err;
+}
+
+// DOS date for 1980-01-01; entries carry no meaningful timestamp.
+static constexpr uint16_t ZIP_DOS_DATE = (1 << 5) | 1;
+static constexpr uint32_t ZIP32_MAX = 0xFFFFFFFF;
+
+void ExtractZipSink::_write_local_header(const Entry &p_entry) {
+	bool zip64 = p_entry.size >= ZIP32_MAX;
+	out->store_32(0x04034b50);
+	out->store_16(zip64 ? 45 : 20); // Version needed to extract.
+	out->store_16(1 << 11); // UTF-8 names.
+	out->store_16(0); // Stored.
+	out->store_16(0);
+	out->store_16(ZIP_DOS_DATE);
+	out->store_32(p_entry.crc);
+	out->store_32(zip64 ? ZIP32_MAX : p_entry.size);
+	out->store_32(zip64 ? ZIP32_MAX : p_entry.size);
+	out->store_16(p_entry.name.length());
+	out->store_16(zip64 ? 20 : 0);
+	out->store_buffer((const uint8_t *)p_entry.name.get_data(), p_entry.name.length());
+	if (zip64) {
+		out->store_16(0x0001);
+		out->store_16(16);
+		out->store_64(p_entry.size);
+		out->store_64(p_entry.size);
+	}
+}
+
+Error ExtractZipSink::write_file(const String &p_path, const uint8_t *p_data, uint64_t p_len) {
+	Entry entry;
+	entry.name = p_path.utf8();
+	entry.size = p_len;
+	entry.crc = crc32(0, Z_NULL, 0);
+	for (uint64_t ofs = 0; ofs < p_len; ofs += UINT32_MAX) {
+		entry.crc = crc32(entry.crc, p_data + ofs, MIN(p_len - ofs, (uint64_t)UINT32_MAX));
+	}
+	MutexLock lock(write_mutex);
+	entry.offset = out->get_position();
+	_write_local_header(entry);
+	out->store_buffer(p_data, p_len);
+	if (out->get_error() != OK) {
+		write_failed = true;
+		return ERR_FILE_CANT_WRITE;
+	}
+	entries.push_back(entry);
+	return OK;
+}
+
+Error ExtractZipSink::write_file_from(const String &p_path, Ref<FileAccess> p_src, uint64_t p_len, CryptoCore::MD5Context *r_md5) {
+	Entry entry;
+	entry.name = p_path.utf8();
+	entry.size = p_len;
+	MutexLock lock(write_mutex);
+	entry.offset = out->get_position();
+	// The CRC is only known once the data has been streamed; patch it into the local header afterwards.
+	_write_local_header(entry);
+	uint32_t crc = crc32(0, Z_NULL, 0);
+	Error err = _stream(out, p_src, p_len, r_md5, &crc);
+	if (err == ERR_FILE_CANT_WRITE) {
+		// The local entry is cut short, so later offsets can't be trusted either.
+		write_failed = true;
+		return err;
+	}
+	// Read errors leave the entry zero-filled to its full length; record it with the CRC of what was written so
+	// the central directory still matches the local headers.
+	entry.crc = crc;
+	uint64_t end = out->get_position();
+	out->seek(entry.offset + 14);
+	out->store_32(entry.crc);
+	out->seek(end);
+	entries.push_back(entry);
+	return err;
+}
+
+Error ExtractZipSink::finish() {
+	MutexLock lock(write_mutex);
+	ERR_FAIL_COND_V(out.is_null(), ERR_UNCONFIGURED);
+	uint64_t cd_offset = out->get_position();
+	for (const Entry &entry : entries) {
+		bool size64 = entry.size >= ZIP32_MAX;
+		bool offset64 = entry.offset >= ZIP32_MAX;
+		uint16_t extra_len = (size64 || offset64) ? 4 + (size64 ? 16 : 0) + (offset64 ? 8 : 0) : 0;
+		out->store_32(0x02014b50);
+		out->store_16((3 << 8) | 45); // Made by: Unix, zip 4.5.
+		out->store_16(extra_len ? 45 : 20);
+		out->store_16(1 << 11);
+		out->store_16(0);
+		out->store_16(0);
+		out->store_16(ZIP_DOS_DATE);
+		out->store_32(entry.crc);
+		out->store_32(size64 ? ZIP32_MAX : entry.size);
+		out->store_32(size64 ? ZIP32_MAX : entry.size);
+		out->store_16(entry.name.length());
+		out->store_16(extra_len);
+		out->store_16(0); // Comment length.
+		out->store_16(0); // Disk number.
+		out->store_16(0); // Internal attributes.
+		out->store_32(0100644u << 16); // Regular file, rw-r--r--.
+		out->store_32(offset64 ? ZIP32_MAX : entry.offset);
+		out->store_buffer((const uint8_t *)entry.name.get_data(), entry.name.length());
+		if (extra_len) {
+			out->store_16(0x0001);
+			out->store_16(extra_len - 4);
+			if (size64) {
+				out->store_64(entry.size);
+				out->store_64(entry.size);
+			}
+			if (offset64) {
+				out->store_64(entry.offset);
+			}
+		}
+	}
+	uint64_t cd_end = out->get_position();
+	uint64_t cd_size = cd_end - cd_offset;
+	uint64_t count = entries.size();
+	if (count >= 0xFFFF || cd_offset >= ZIP32_MAX || cd_size >= ZIP32_MAX) {
+		out->store_32(0x06064b50);
+		out->store_64(44);
+		out->store_16((3 << 8) | 45);
+		out->store_16(45);
+		out->store_32(0);
+		out->store_32(0);
+		out->store_64(count);
+		out->store_64(count);
+		out->store_64(cd_size);
+		out->store_64(cd_offset);
+		out->store_32(0x07064b50);
+		out->store_32(0);
+		out->store_64(cd_end);
+		out->store_32(1);
+	}
+	out->store_32(0x06054b50);
+	out->store_16(0);
+	out->store_16(0);
+	out->store_16(MIN(count, (uint64_t)0xFFFF));
+	out->store_16(MIN(count, (uint64_t)0xFFFF));
+	out->store_32(MIN(cd_size, (uint64_t)ZIP32_MAX));
+	out->store_32(MIN(cd_offset, (uint64_t)ZIP32_MAX));
+	out->store_16(0);
+	out->flush();
+	Error err = (out->get_error() == OK && !write_failed) ? OK : ERR_FILE_CANT_WRITE;
+	out.unref();
+	entries.clear();
+	return err;
+}
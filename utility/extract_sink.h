@@ -0,0 +1,107 @@
+#pragma once
+
+#include "core/crypto/crypto_core.h"
+#include "core/io/file_access.h"
+#include "core/object/ref_counted.h"
+#include "core/os/mutex.h"
+#include "core/templates/hash_set.h"
+#include "core/templates/local_vector.h"
+
+// Where extracted files go. Paths are relative to the output root; all methods may be called from several
+// writer threads at once.
+class ExtractSink : public RefCounted {
+	GDSOFTCLASS(ExtractSink, RefCounted);
+
+protected:
+	// Copies p_len bytes; if p_src comes up short the rest is zero-filled so archive framing stays intact and
+	// ERR_FILE_CANT_READ is returned. Errors p_src reports after the copy (such as ERR_FILE_CORRUPT) are returned too.
+	static Error _stream(Ref<FileAccess> p_dst, Ref<FileAccess> p_src, uint64_t p_len, CryptoCore::MD5Context *r_md5, uint32_t *r_crc = nullptr);
+
+public:
+	virtual Error write_file(const String &p_path, const uint8_t *p_data, uint64_t p_len) = 0;
+	// Streams p_len bytes from p_src, feeding them to r_md5 as well if given. Fails with ERR_FILE_CANT_READ on a short
+	// read, or with the error p_src reports once everything has been read.
+	virtual Error write_file_from(const String &p_path, Ref<FileAccess> p_src, uint64_t p_len, CryptoCore::MD5Context *r_md5 = nullptr) = 0;
+	// Copies a byte range of an unencrypted pack without passing it through user space.
+	virtual bool can_copy_range() const { return false; }
+	virtual Error copy_range(const String &p_path, const String &p_pack, uint64_t p_offset, uint64_t p_len) { return ERR_UNAVAILABLE; }
+	// Whether extracted files stay around as individual files that later runs can compare against.
+	virtual bool is_directory() const { return false; }
+	virtual String get_target_path(const String &p_path) const = 0;
+	// Writes any trailer and closes the output.
+	virtual Error finish() { return OK; }
+
+	// A tar or uncompressed zip writer for paths ending in ".tar" or ".zip", otherwise a directory writer.
+	static Ref<ExtractSink> create(const String &p_output);
+};
+
+class ExtractDirSink : public ExtractSink {
+	GDSOFTCLASS(ExtractDirSink, ExtractSink);
+
+	String output_dir;
+	// Directories already created, so each one is only checked once.
+	Mutex dir_cache_mutex;
+	HashSet<String> created_dirs;
+
+	Error _ensure_dir_cached(const String &p_dir);
+
+public:
+	virtual Error write_file(const String &p_path, const uint8_t *p_data, uint64_t p_len) override;
+	virtual Error write_file_from(const String &p_path, Ref<FileAccess> p_src, uint64_t p_len, CryptoCore::MD5Context *r_md5 = nullptr) override;
+	virtual bool can_copy_range() const override { return true; }
+	virtual Error copy_range(const String &p_path, const String &p_pack, uint64_t p_offset, uint64_t p_len) override;
+	virtual bool is_directory() const override { return true; }
+	virtual String get_target_path(const String &p_path) const override { return output_dir.path_join(p_path); }
+
+	ExtractDirSink(const String &p_output_dir) :
+			output_dir(p_output_dir) {}
+};
+
+// Base for sinks that append every file to one archive; whole files are written under a lock, in arrival order.
+class ExtractArchiveSink : public ExtractSink {
+	GDSOFTCLASS(ExtractArchiveSink, ExtractSink);
+
+protected:
+	String archive_path;
+	Ref<FileAccess> out;
+	Mutex write_mutex;
+	// Set when an entry could only be partly written; the archive is then broken and finish() fails.
+	bool write_failed = false;
+
+public:
+	Error open(const String &p_archive_path);
+	virtual String get_target_path(const String &p_path) const override { return archive_path + "::" + p_path; }
+};
+
+// POSIX ustar stream. Names over 100 bytes use GNU long name records, and sizes over 8 GiB use base-256.
+class ExtractTarSink : public ExtractArchiveSink {
+	GDSOFTCLASS(ExtractTarSink, ExtractArchiveSink);
+
+	void _write_header(const CharString &p_name, uint64_t p_size, char p_type);
+	void _pad(uint64_t p_size);
+
+public:
+	virtual Error write_file(const String &p_path, const uint8_t *p_data, uint64_t p_len) override;
+	virtual Error write_file_from(const String &p_path, Ref<FileAccess> p_src, uint64_t p_len, CryptoCore::MD5Context *r_md5 = nullptr) override;
+	virtual Error finish() override;
+};
+
+// Zip with stored (uncompressed) entries, using zip64 records where sizes, offsets or the entry count need them.
+class ExtractZipSink : public ExtractArchiveSink {
+	GDSOFTCLASS(ExtractZipSink, ExtractArchiveSink);
+
+	struct Entry {
+		CharString name;
+		uint32_t crc = 0;
+		uint64_t size = 0;
+		uint64_t offset = 0;
+	};
+	LocalVector<Entry> entries;
+
+	void _write_local_header(const Entry &p_entry);
+
+public:
+	virtual Error write_file(const String &p_path, const uint8_t *p_data, uint64_t p_len) override;
+	virtual Error write_file_from(const String &p_path, Ref<FileAccess> p_src, uint64_t p_len, CryptoCore::MD5Context *r_md5 = nullptr) override;
+	virtual Error finish() override;
+};
@@ -30,129 +30,107 @@
 #include "file_access_apk.h"
 
 #ifdef MINIZIP_ENABLED
-#include "thirdparty/minizip/ioapi.h"
-
 #include "axml_parser.h"
 #include "file_access_gdre.h"
 #include "gdre_settings.h"
 
 #include "core/io/file_access.h"
+#include "core/io/marshalls.h"
 
 APKArchive *APKArchive::instance = nullptr;
 
-extern "C" {
-
-struct APKData {
-	Ref<FileAccess> f;
-};
-
-static void *godot_open(voidpf opaque, const void *p_fname, int mode) {
-	if (mode & ZLIB_FILEFUNC_MODE_WRITE) {
-		return nullptr;
-	}
-
-	Ref<FileAccess> f = FileAccess::open(String::utf8((const char *)p_fname), FileAccess::READ);
-	ERR_FAIL_COND_V(f.is_null(), nullptr);
-
-	APKData *zd = memnew(APKData);
-	zd->f = f;
-	return zd;
-}
-
-static uLong godot_read(voidpf opaque, voidpf stream, void *buf, uLong size) {
-	APKData *zd = (APKData *)stream;
-	zd->f->get_buffer((uint8_t *)buf, size);
-	return size;
-}
-
-static uLong godot_write(voidpf opaque, voidpf stream, const void *buf, uLong size) {
-	return 0;
-}
-
-static ZPOS64_T godot_tell(voidpf opaque, voidpf stream) {
-	APKData *zd = (APKData *)stream;
-	return zd->f->get_position();
-}
-
-static long godot_seek(voidpf opaque, voidpf stream, ZPOS64_T offset, int origin) {
-	APKData *zd = (APKData *)stream;
-
-	uint64_t pos = offset;
-	switch (origin) {
-		case ZLIB_FILEFUNC_SEEK_CUR:
-			pos = zd->f->get_position() + offset;
-			break;
-		case ZLIB_FILEFUNC_SEEK_END:
-			pos = zd->f->get_length() + offset;
-			break;
-		default:
+namespace {
+constexpr uint32_t ZIP_LOCAL_HEADER_SIG = 0x04034b50;
+constexpr uint32_t ZIP_CENTRAL_HEADER_SIG = 0x02014b50;
+constexpr uint32_t ZIP_EOCD_SIG = 0x06054b50;
+constexpr uint32_t ZIP64_EOCD_LOCATOR_SIG = 0x07064b50;
+constexpr uint32_t ZIP64_EOCD_SIG = 0x06064b50;
+constexpr uint32_t ZIP_LOCAL_HEADER_SIZE = 30;
+constexpr uint32_t ZIP_CENTRAL_HEADER_SIZE = 46;
+constexpr uint32_t ZIP_EOCD_SIZE = 22;
+constexpr uint32_t ZIP64_EOCD_LOCATOR_SIZE = 20;
+constexpr uint32_t ZIP64_EOCD_SIZE = 56;
+constexpr uint32_t ZIP_MAX_COMMENT_SIZE = 0xFFFF;
+} //namespace
+
+Error APKArchive::_read_central_directory(Ref<FileAccess> p_f, uint64_t &r_base_offset, Vector<uint8_t> &r_cdir, uint64_t &r_entry_count) {
+	uint64_t file_len = p_f->get_length();
+	ERR_FAIL_COND_V(file_len < ZIP_EOCD_SIZE, ERR_FILE_CORRUPT);
+
+	// The end of central directory record sits at the end of the file, followed by a comment of up to 64k.
+	uint64_t tail_len = MIN(file_len, (uint64_t)(ZIP_EOCD_SIZE + ZIP_MAX_COMMENT_SIZE));
+	Vector<uint8_t> tail;
+	tail.resize(tail_len);
+	p_f->seek(file_len - tail_len);
+	ERR_FAIL_COND_V(p_f->get_buffer(tail.ptrw(), tail_len) != tail_len, ERR_FILE_CANT_READ);
+	const uint8_t *t = tail.ptr();
+	int64_t eocd = -1;
+	for (int64_t i = tail_len - ZIP_EOCD_SIZE; i >= 0; i--) {
+		if (decode_uint32(&t[i]) == ZIP_EOCD_SIG) {
+			eocd = i;
 			break;
+		}
 	}
-
-	zd->f->seek(pos);
-	return 0;
-}
-
-static int godot_close(voidpf opaque, voidpf stream) {
-	APKData *zd = (APKData *)stream;
-	memdelete(zd);
-	return 0;
-}
-
-static int godot_testerror(voidpf opaque, voidpf stream) {
-	APKData *zd = (APKData *)stream;
-	return zd->f->get_error() != OK ? 1 : 0;
-}
-
-static voidpf godot_alloc(voidpf opaque, uInt items, uInt size) {
-	return memalloc((size_t)items * size);
-}
-
-static void godot_free(voidpf opaque, voidpf address) {
-	memfree(address);
+	ERR_FAIL_COND_V_MSG(eocd < 0, ERR_FILE_UNRECOGNIZED, "Cannot find the end of central directory record.");
+	uint64_t eocd_pos = file_len - tail_len + eocd;
+
+	uint64_t entry_count = decode_uint16(&t[eocd + 10]);
+	uint64_t cdir_size = decode_uint32(&t[eocd + 12]);
+	uint64_t cdir_offset = decode_uint32(&t[eocd + 16]);
+	uint64_t cdir_end = eocd_pos;
+
+	if (entry_count == 0xFFFF || cdir_size == 0xFFFFFFFF || cdir_offset == 0xFFFFFFFF) {
+		ERR_FAIL_COND_V(eocd_pos < ZIP64_EOCD_LOCATOR_SIZE, ERR_FILE_CORRUPT);
+		uint8_t locator[ZIP64_EOCD_LOCATOR_SIZE];
+		p_f->seek(eocd_pos - ZIP64_EOCD_LOCATOR_SIZE);
+		p_f->get_buffer(locator, ZIP64_EOCD_LOCATOR_SIZE);
+		if (decode_uint32(locator) == ZIP64_EOCD_LOCATOR_SIG) {
+			uint64_t zip64_eocd_pos = decode_uint64(&locator[8]);
+			uint8_t zip64_eocd[ZIP64_EOCD_SIZE];
+			p_f->seek(zip64_eocd_pos);
+			ERR_FAIL_COND_V(p_f->get_buffer(zip64_eocd, ZIP64_EOCD_SIZE) != ZIP64_EOCD_SIZE, ERR_FILE_CORRUPT);
+			ERR_FAIL_COND_V_MSG(decode_uint32(zip64_eocd) != ZIP64_EOCD_SIG, ERR_FILE_CORRUPT, "Invalid zip64 end of central directory record.");
+			entry_count = decode_uint64(&zip64_eocd[32]);
+			cdir_size = decode_uint64(&zip64_eocd[40]);
+			cdir_offset = decode_uint64(&zip64_eocd[48]);
+			cdir_end = zip64_eocd_pos;
+		}
+	}
+	ERR_FAIL_COND_V(cdir_size > cdir_end, ERR_FILE_CORRUPT);
+	// Anything prepended to the archive (e.g. a self-extracting stub) shifts every recorded offset.
+	uint64_t cdir_start = cdir_end - cdir_size;
+	ERR_FAIL_COND_V(cdir_start < cdir_offset, ERR_FILE_CORRUPT);
+	r_base_offset = cdir_start - cdir_offset;
+
+	r_cdir.resize(cdir_size);
+	p_f->seek(cdir_start);
+	ERR_FAIL_COND_V(p_f->get_buffer(r_cdir.ptrw(), cdir_size) != cdir_size, ERR_FILE_CANT_READ);
+	r_entry_count = entry_count;
+	return OK;
 }
-} // extern "C"
 
-void APKArchive::close_handle(unzFile p_file) const {
-	ERR_FAIL_COND_MSG(!p_file, "Cannot close a file if none is open.");
-	unzCloseCurrentFile(p_file);
-	unzClose(p_file);
+bool APKArchive::get_file_entry(const String &p_file, File &r_file, String &r_package_path) const {
+	const File *file = files.getptr(p_file);
+	ERR_FAIL_COND_V_MSG(!file, false, "File '" + p_file + " doesn't exist.");
+	r_file = *file;
+	r_package_path = packages[file->package].filename;
+	return true;
 }
 
-unzFile APKArchive::get_file_handle(String p_file) const {
-	ERR_FAIL_COND_V_MSG(!file_exists(p_file), nullptr, "File '" + p_file + " doesn't exist.");
-	File file = files[p_file];
-
-	zlib_filefunc64_def io;
-	memset(&io, 0, sizeof(io));
-
-	io.opaque = nullptr;
-	io.zopen64_file = godot_open;
-	io.zread_file = godot_read;
-	io.zwrite_file = godot_write;
-
-	io.ztell64_file = godot_tell;
-	io.zseek64_file = godot_seek;
-	io.zclose_file = godot_close;
-	io.zerror_file = godot_testerror;
-
-	io.alloc_mem = godot_alloc;
-	io.free_mem = godot_free;
-
-	unzFile pkg = unzOpen2_64(packages[file.package].filename.utf8().get_data(), &io);
-	ERR_FAIL_COND_V_MSG(!pkg, nullptr, "Cannot open file '" + packages[file.package].filename + "'.");
-	int unz_err = unzGoToFilePos(pkg, &file.file_pos);
-	if (unz_err != UNZ_OK || unzOpenCurrentFile(pkg) != UNZ_OK) {
-		unzClose(pkg);
-		ERR_FAIL_V(nullptr);
-	}
-
-	return pkg;
+uint64_t APKArchive::get_data_offset(Ref<FileAccess> p_package, const File &p_file) const {
+	uint64_t header_pos = packages[p_file.package].base_offset + p_file.local_header_offset;
+	uint8_t header[ZIP_LOCAL_HEADER_SIZE];
+	p_package->seek(header_pos);
+	ERR_FAIL_COND_V(p_package->get_buffer(header, ZIP_LOCAL_HEADER_SIZE) != ZIP_LOCAL_HEADER_SIZE, 0);
+	ERR_FAIL_COND_V_MSG(decode_uint32(header) != ZIP_LOCAL_HEADER_SIG, 0, "Invalid local file header.");
+	// The local extra field may differ from the central directory one, so it has to be read from here.
+	return header_pos + ZIP_LOCAL_HEADER_SIZE + decode_uint16(&header[26]) + decode_uint16(&header[28]);
 }
 
 Error APKArchive::get_version_string_from_manifest(String &version_string) {
 	AXMLParser parser;
-	Ref<FileAccessAPK> thing = memnew(FileAccessAPK("AndroidManifest.xml"));
+	Ref<FileAccessAPK> thing = memnew(FileAccessAPK(this, "AndroidManifest.xml"));
+	ERR_FAIL_COND_V(!thing->is_open(), ERR_FILE_CANT_OPEN);
 	Vector<uint8_t> buf;
 	buf.resize(thing->get_length());
 	thing->get_buffer(buf.ptrw(), thing->get_length());
@@ -177,32 +155,17 @@ bool APKArchive::try_open_pack(const String &p_path, bool p_replace_files, uint6
 		return false;
 	}
 	bool is_apk = ext == "apk";
-	zlib_filefunc64_def io;
-	memset(&io, 0, sizeof(io));
-
-	io.opaque = nullptr;
-	io.zopen64_file = godot_open;
-	io.zread_file = godot_read;
-	io.zwrite_file = godot_write;
-
-	io.ztell64_file = godot_tell;
-	io.zseek64_file = godot_seek;
-	io.zclose_file = godot_close;
-	io.zerror_file = godot_testerror;
-
-	io.alloc_mem = godot_alloc;
-	io.free_mem = godot_free;
-
-	unzFile zfile = unzOpen2_64(pack_path.utf8().get_data(), &io);
-	ERR_FAIL_COND_V(!zfile, false);
-
-	unz_global_info64 gi;
-	int err = unzGetGlobalInfo64(zfile, &gi);
-	ERR_FAIL_COND_V(err != UNZ_OK, false);
 
+	Ref<FileAccess> fa = FileAccess::open(pack_path, FileAccess::READ);
+	ERR_FAIL_COND_V(fa.is_null(), false);
 	Package pkg;
 	pkg.filename = pack_path;
-	pkg.zfile = zfile;
+	Vector<uint8_t> cdir;
+	uint64_t entry_count = 0;
+	Error err = _read_central_directory(fa, pkg.base_offset, cdir, entry_count);
+	ERR_FAIL_COND_V(err != OK, false);
+	fa.unref();
+
 	packages.push_back(pkg);
 	int pkg_num = packages.size() - 1;
 	uint32_t asset_count = 0;
@@ -210,18 +173,53 @@ bool APKArchive::try_open_pack(const String &p_path, bool p_replace_files, uint6
 	Ref<GodotVer> godot_ver;
 	godot_ver.instantiate();
 	String ver_string = "unknown";
-	for (uint64_t i = 0; i < gi.number_entry; i++) {
-		char filename_inzip[256];
-
-		unz_file_info64 file_info;
-		err = unzGetCurrentFileInfo64(zfile, &file_info, filename_inzip, sizeof(filename_inzip), nullptr, 0, nullptr, 0);
-		ERR_CONTINUE(err != UNZ_OK);
+	const uint8_t *cd = cdir.ptr();
+	uint64_t cdir_size = cdir.size();
+	uint64_t ofs = 0;
+	for (uint64_t i = 0; i < entry_count; i++) {
+		ERR_BREAK_MSG(ofs + ZIP_CENTRAL_HEADER_SIZE > cdir_size, "Central directory is truncated.");
+		const uint8_t *h = &cd[ofs];
+		ERR_BREAK_MSG(decode_uint32(h) != ZIP_CENTRAL_HEADER_SIG, "Invalid central directory record.");
+		uint32_t name_len = decode_uint16(&h[28]);
+		uint32_t extra_len = decode_uint16(&h[30]);
+		uint32_t comment_len = decode_uint16(&h[32]);
+		ERR_BREAK_MSG(ofs + ZIP_CENTRAL_HEADER_SIZE + name_len + extra_len + comment_len > cdir_size, "Central directory is truncated.");
 
 		File f;
 		f.package = pkg_num;
+		f.method = decode_uint16(&h[10]);
+		f.crc32 = decode_uint32(&h[16]);
+		f.compressed_size = decode_uint32(&h[20]);
+		f.uncompressed_size = decode_uint32(&h[24]);
+		f.local_header_offset = decode_uint32(&h[42]);
+
+		// Zip64 extended information only contains the fields that overflowed, in this order.
+		const uint8_t *extra = &h[ZIP_CENTRAL_HEADER_SIZE + name_len];
+		for (uint32_t e = 0; e + 4 <= extra_len;) {
+			uint16_t id = decode_uint16(&extra[e]);
+			uint16_t sz = decode_uint16(&extra[e + 2]);
+			if (id == 0x0001) {
+				const uint8_t *z = &extra[e + 4];
+				const uint8_t *z_end = z + MIN((uint32_t)sz, extra_len - e - 4);
+				if (f.uncompressed_size == 0xFFFFFFFF && z + 8 <= z_end) {
+					f.uncompressed_size = decode_uint64(z);
+					z += 8;
+				}
+				if (f.compressed_size == 0xFFFFFFFF && z + 8 <= z_end) {
+					f.compressed_size = decode_uint64(z);
+					z += 8;
+				}
+				if (f.local_header_offset == 0xFFFFFFFF && z + 8 <= z_end) {
+					f.local_header_offset = decode_uint64(z);
+				}
+				break;
+			}
+			e += 4 + sz;
+		}
+
+		String original_fname = String::utf8((const char *)&h[ZIP_CENTRAL_HEADER_SIZE], name_len);
+		ofs += ZIP_CENTRAL_HEADER_SIZE + name_len + extra_len + comment_len;
 
-		unzGetFilePos(zfile, &f.file_pos);
-		String original_fname = String::utf8(filename_inzip);
 		String fname;
 		if (is_apk) {
 			if (original_fname == "AndroidManifest.xml") {
@@ -236,18 +234,9 @@ bool APKArchive::try_open_pack(const String &p_path, bool p_replace_files, uint6
 				} else {
 					godot_ver = GodotVer::parse(ver_string);
 				}
-
-				// reset the position
-				unzGoToFilePos(zfile, &f.file_pos);
-				if ((i + 1) < gi.number_entry) {
-					unzGoToNextFile(zfile);
-				}
 				continue;
 			} else if (!original_fname.begins_with("assets/")) {
 				files[original_fname] = f;
-				if ((i + 1) < gi.number_entry) {
-					unzGoToNextFile(zfile);
-				}
 				continue;
 			} else {
 				fname = original_fname.replace_first("assets/", "res://");
@@ -260,11 +249,7 @@ bool APKArchive::try_open_pack(const String &p_path, bool p_replace_files, uint6
 		files[fname] = f;
 
 		static constexpr const uint8_t md5[16] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
-		GDREPackedData::get_singleton()->add_path(pack_path, fname, 1, file_info.uncompressed_size, md5, this, p_replace_files, false);
-
-		if ((i + 1) < gi.number_entry) {
-			unzGoToNextFile(zfile);
-		}
+		GDREPackedData::get_singleton()->add_path(pack_path, fname, 1, f.uncompressed_size, md5, this, p_replace_files, false);
 	}
 	Ref<GDRESettings::PackInfo> pckinfo;
 	pckinfo.instantiate();
@@ -279,7 +264,7 @@ bool APKArchive::file_exists(String p_name) const {
 }
 
 Ref<FileAccess> APKArchive::get_file(const String &p_path, PackedData::PackedFile *p_file) {
-	return memnew(FileAccessAPK(p_path, *p_file));
+	return memnew(FileAccessAPK(this, p_path));
 }
 
 APKArchive *APKArchive::get_singleton() {
@@ -295,66 +280,155 @@ APKArchive::APKArchive() {
 }
 
 APKArchive::~APKArchive() {
-	for (int i = 0; i < packages.size(); i++) {
-		unzClose(packages[i].zfile);
+	if (instance == this) {
+		instance = nullptr;
 	}
-
 	packages.clear();
 }
 
-Error FileAccessAPK::open_internal(const String &p_path, int p_mode_flags) {
+Error FileAccessAPK::_open_entry(const APKArchive *p_archive, const String &p_path) {
 	_close();
 
+	String package_path;
+	ERR_FAIL_COND_V(!p_archive->get_file_entry(p_path, entry, package_path), ERR_FILE_NOT_FOUND);
+	ERR_FAIL_COND_V_MSG(entry.method != APKArchive::METHOD_STORED && entry.method != APKArchive::METHOD_DEFLATED, ERR_UNAVAILABLE, "Unsupported compression method " + itos(entry.method) + " for '" + p_path + "'.");
+	f = FileAccess::open(package_path, FileAccess::READ);
+	ERR_FAIL_COND_V_MSG(f.is_null(), ERR_FILE_CANT_OPEN, "Cannot open file '" + package_path + "'.");
+	data_offset = p_archive->get_data_offset(f, entry);
+	if (data_offset == 0) {
+		f.unref();
+		ERR_FAIL_V(ERR_FILE_CORRUPT);
+	}
+	pos = 0;
+	at_eof = false;
+	if (entry.method == APKArchive::METHOD_DEFLATED) {
+		Error err = _reset_inflate();
+		if (err != OK) {
+			f.unref();
+			return err;
+		}
+	}
+	return OK;
+}
+
+Error FileAccessAPK::open_internal(const String &p_path, int p_mode_flags) {
 	ERR_FAIL_COND_V(p_mode_flags & FileAccess::WRITE, FAILED);
 	APKArchive *arch = APKArchive::get_singleton();
 	ERR_FAIL_COND_V(!arch, FAILED);
-	zfile = arch->get_file_handle(p_path);
-	ERR_FAIL_COND_V(!zfile, FAILED);
-
-	int err = unzGetCurrentFileInfo64(zfile, &file_info, nullptr, 0, nullptr, 0, nullptr, 0);
-	ERR_FAIL_COND_V(err != UNZ_OK, FAILED);
+	return _open_entry(arch, p_path);
+}
 
+Error FileAccessAPK::_reset_inflate() const {
+	if (strm_initialized) {
+		inflateEnd(&strm);
+		strm_initialized = false;
+	}
+	memset(&strm, 0, sizeof(strm));
+	// Raw deflate data, no zlib header.
+	ERR_FAIL_COND_V(inflateInit2(&strm, -MAX_WBITS) != Z_OK, ERR_CANT_CREATE);
+	strm_initialized = true;
+	strm_end = false;
+	compressed_pos = 0;
+	pos = 0;
+	at_eof = false;
+	in_buf.resize(INFLATE_CHUNK_SIZE);
 	return OK;
 }
 
-void FileAccessAPK::_close() {
-	if (!zfile) {
+void FileAccessAPK::_add_checkpoint(uint64_t p_out_pos) const {
+	InflateCheckpoint cp;
+	cp.out_pos = p_out_pos;
+	cp.in_pos = compressed_pos - strm.avail_in;
+	cp.bits = strm.data_type & 7;
+	cp.window.resize(32768);
+	uInt window_len = 0;
+	if (inflateGetDictionary(&strm, cp.window.ptrw(), &window_len) != Z_OK) {
 		return;
 	}
+	cp.window.resize(window_len);
+	checkpoints.push_back(cp);
+}
+
+Error FileAccessAPK::_restore_checkpoint(const InflateCheckpoint &p_checkpoint) const {
+	Error err = _reset_inflate();
+	ERR_FAIL_COND_V(err != OK, err);
+	if (p_checkpoint.bits > 0) {
+		// The block boundary falls inside a byte; feed its remaining bits back in before resuming.
+		uint8_t partial = 0;
+		f->seek(data_offset + p_checkpoint.in_pos - 1);
+		f->get_buffer(&partial, 1);
+		ERR_FAIL_COND_V(inflatePrime(&strm, p_checkpoint.bits, partial >> (8 - p_checkpoint.bits)) != Z_OK, ERR_FILE_CORRUPT);
+	}
+	ERR_FAIL_COND_V(inflateSetDictionary(&strm, p_checkpoint.window.ptr(), p_checkpoint.window.size()) != Z_OK, ERR_FILE_CORRUPT);
+	compressed_pos = p_checkpoint.in_pos;
+	pos = p_checkpoint.out_pos;
+	return OK;
+}
 
-	APKArchive *arch = APKArchive::get_singleton();
-	ERR_FAIL_COND(!arch);
-	arch->close_handle(zfile);
-	zfile = nullptr;
+void FileAccessAPK::_close() {
+	if (strm_initialized) {
+		inflateEnd(&strm);
+		strm_initialized = false;
+	}
+	in_buf.clear();
+	checkpoints.clear();
+	f.unref();
+	pos = 0;
+	at_eof = false;
 }
 
 bool FileAccessAPK::is_open() const {
-	return zfile != nullptr;
+	return f.is_valid();
 }
 
 void FileAccessAPK::seek(uint64_t p_position) {
-	ERR_FAIL_COND(!zfile);
-
-	unzSeekCurrentFile(zfile, p_position);
+	ERR_FAIL_COND(f.is_null());
+	p_position = MIN(p_position, entry.uncompressed_size);
+	at_eof = false;
+	if (entry.method == APKArchive::METHOD_STORED) {
+		pos = p_position;
+		return;
+	}
+	// Resume from the closest checkpoint at or before the target if that beats inflating from where we are.
+	const InflateCheckpoint *nearest = nullptr;
+	for (int64_t i = (int64_t)checkpoints.size() - 1; i >= 0; i--) {
+		if (checkpoints[i].out_pos <= p_position) {
+			nearest = &checkpoints[i];
+			break;
+		}
+	}
+	if (nearest && (p_position < pos || nearest->out_pos > pos)) {
+		ERR_FAIL_COND(_restore_checkpoint(*nearest) != OK);
+	} else if (p_position < pos) {
+		ERR_FAIL_COND(_reset_inflate() != OK);
+	}
+	// Deflate streams can only be walked forward; decode and discard up to the target.
+	uint8_t discard[4096];
+	while (pos < p_position) {
+		uint64_t read = _read_deflated(discard, MIN((uint64_t)sizeof(discard), p_position - pos));
+		if (read == 0) {
+			break;
+		}
+	}
 }
 
 void FileAccessAPK::seek_end(int64_t p_position) {
-	ERR_FAIL_COND(!zfile);
-	unzSeekCurrentFile(zfile, get_length() + p_position);
+	ERR_FAIL_COND(f.is_null());
+	seek(get_length() + p_position);
 }
 
 uint64_t FileAccessAPK::get_position() const {
-	ERR_FAIL_COND_V(!zfile, 0);
-	return unztell(zfile);
+	ERR_FAIL_COND_V(f.is_null(), 0);
+	return pos;
 }
 
 uint64_t FileAccessAPK::get_length() const {
-	ERR_FAIL_COND_V(!zfile, 0);
-	return file_info.uncompressed_size;
+	ERR_FAIL_COND_V(f.is_null(), 0);
+	return entry.uncompressed_size;
 }
 
 bool FileAccessAPK::eof_reached() const {
-	ERR_FAIL_COND_V(!zfile, true);
+	ERR_FAIL_COND_V(f.is_null(), true);
 
 	return at_eof;
 }
@@ -365,24 +439,71 @@ uint8_t FileAccessAPK::get_8() const {
 	return ret;
 }
 
+uint64_t FileAccessAPK::_read_stored(uint8_t *p_dst, uint64_t p_length) const {
+	// Stored entries are read straight from the package into the caller's buffer.
+	f->seek(data_offset + pos);
+	uint64_t read = f->get_buffer(p_dst, p_length);
+	pos += read;
+	return read;
+}
+
+uint64_t FileAccessAPK::_read_deflated(uint8_t *p_dst, uint64_t p_length) const {
+	uint64_t total = 0;
+	while (total < p_length && !strm_end) {
+		if (strm.avail_in == 0) {
+			uint64_t remaining = entry.compressed_size - compressed_pos;
+			if (remaining == 0) {
+				break;
+			}
+			uint64_t chunk = MIN(remaining, (uint64_t)INFLATE_CHUNK_SIZE);
+			f->seek(data_offset + compressed_pos);
+			uint64_t got = f->get_buffer(in_buf.ptr(), chunk);
+			if (got == 0) {
+				break;
+			}
+			compressed_pos += got;
+			strm.next_in = in_buf.ptr();
+			strm.avail_in = (uInt)got;
+		}
+		uint32_t want = (uint32_t)MIN(p_length - total, (uint64_t)UINT32_MAX);
+		strm.next_out = p_dst + total;
+		strm.avail_out = want;
+		// Stop at block boundaries once we are a span past the last checkpoint so the next one can be taken.
+		uint64_t last_checkpoint = checkpoints.is_empty() ? 0 : checkpoints[checkpoints.size() - 1].out_pos;
+		bool want_checkpoint = pos + total >= last_checkpoint + INFLATE_CHECKPOINT_SPAN;
+		int ret = inflate(&strm, want_checkpoint ? Z_BLOCK : Z_NO_FLUSH);
+		total += want - strm.avail_out;
+		if (want_checkpoint && ret == Z_OK && (strm.data_type & 128) && !(strm.data_type & 64)) {
+			_add_checkpoint(pos + total);
+		}
+		if (ret == Z_STREAM_END) {
+			strm_end = true;
+		} else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+			ERR_PRINT("Inflate failed with error " + itos(ret) + ".");
+			strm_end = true;
+		}
+	}
+	pos += total;
+	return total;
+}
+
 uint64_t FileAccessAPK::get_buffer(uint8_t *p_dst, uint64_t p_length) const {
 	ERR_FAIL_COND_V(!p_dst && p_length > 0, -1);
-	ERR_FAIL_COND_V(!zfile, -1);
+	ERR_FAIL_COND_V(f.is_null(), -1);
 
-	at_eof = unzeof(zfile);
-	if (at_eof) {
-		return 0;
+	uint64_t to_read = MIN(p_length, entry.uncompressed_size - pos);
+	uint64_t read = 0;
+	if (to_read > 0) {
+		read = entry.method == APKArchive::METHOD_STORED ? _read_stored(p_dst, to_read) : _read_deflated(p_dst, to_read);
 	}
-	int64_t read = unzReadCurrentFile(zfile, p_dst, p_length);
-	ERR_FAIL_COND_V(read < 0, read);
-	if ((uint64_t)read < p_length) {
+	if (read < p_length) {
 		at_eof = true;
 	}
 	return read;
 }
 
 Error FileAccessAPK::get_error() const {
-	if (!zfile) {
+	if (f.is_null()) {
 		return ERR_UNCONFIGURED;
 	}
 	if (eof_reached()) {
@@ -412,8 +533,8 @@ void FileAccessAPK::close() {
 FileAccessAPK::FileAccessAPK(const String &p_path) {
 	open_internal(p_path, FileAccess::READ);
 }
-FileAccessAPK::FileAccessAPK(const String &p_path, const PackedData::PackedFile &p_file) {
-	open_internal(p_path, FileAccess::READ);
+FileAccessAPK::FileAccessAPK(const APKArchive *p_archive, const String &p_path) {
+	_open_entry(p_archive, p_path);
 }
 
 FileAccessAPK::~FileAccessAPK() {
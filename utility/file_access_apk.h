@@ -34,23 +34,32 @@
 #ifdef MINIZIP_ENABLED
 
 #include "core/io/file_access_pack.h"
+#include "core/templates/local_vector.h"
 
-#include "thirdparty/minizip/unzip.h"
+#include <zlib.h>
 
 #include <stdlib.h>
 
 class APKArchive : public PackSource {
 public:
+	// One central directory record; parsed once when the package is opened.
 	struct File {
 		int package = -1;
-		unz_file_pos file_pos;
+		uint64_t local_header_offset = 0;
+		uint64_t compressed_size = 0;
+		uint64_t uncompressed_size = 0;
+		uint32_t crc32 = 0;
+		uint16_t method = 0;
 		File() {}
 	};
 
+	static constexpr uint16_t METHOD_STORED = 0;
+	static constexpr uint16_t METHOD_DEFLATED = 8;
+
 private:
 	struct Package {
 		String filename;
-		unzFile zfile = nullptr;
+		uint64_t base_offset = 0;
 	};
 	Vector<Package> packages;
 
@@ -58,11 +67,13 @@ private:
 
 	static APKArchive *instance;
 
+	static Error _read_central_directory(Ref<FileAccess> p_f, uint64_t &r_base_offset, Vector<uint8_t> &r_cdir, uint64_t &r_entry_count);
+
 public:
 	Error get_version_string_from_manifest(String &version_string);
 
-	void close_handle(unzFile p_file) const;
-	unzFile get_file_handle(String p_file) const;
+	bool get_file_entry(const String &p_file, File &r_file, String &r_package_path) const;
+	uint64_t get_data_offset(Ref<FileAccess> p_package, const File &p_file) const;
 
 	Error add_package(String p_name);
 
@@ -77,13 +88,42 @@ public:
 	~APKArchive();
 };
 
+// Each instance owns its own handle to the package and its own inflate stream, so entries can be read from
+// several threads at once without touching shared state.
 class FileAccessAPK : public FileAccess {
 	GDSOFTCLASS(FileAccessAPK, FileAccess);
-	unzFile zfile = nullptr;
-	unz_file_info64 file_info;
+	static constexpr uint32_t INFLATE_CHUNK_SIZE = 64 * 1024;
+	// Distance between inflate checkpoints; each one keeps a copy of the 32 KiB deflate window.
+	static constexpr uint64_t INFLATE_CHECKPOINT_SPAN = 512 * 1024;
+
+	// zran-style resume point at a deflate block boundary.
+	struct InflateCheckpoint {
+		uint64_t out_pos = 0;
+		uint64_t in_pos = 0;
+		int bits = 0;
+		Vector<uint8_t> window;
+	};
+
+	Ref<FileAccess> f;
+	APKArchive::File entry;
+	uint64_t data_offset = 0;
 
+	mutable uint64_t pos = 0;
 	mutable bool at_eof = false;
 
+	mutable z_stream strm;
+	mutable bool strm_initialized = false;
+	mutable bool strm_end = false;
+	mutable uint64_t compressed_pos = 0;
+	mutable LocalVector<uint8_t> in_buf;
+	mutable LocalVector<InflateCheckpoint> checkpoints;
+
+	Error _open_entry(const APKArchive *p_archive, const String &p_path);
+	Error _reset_inflate() const;
+	void _add_checkpoint(uint64_t p_out_pos) const;
+	Error _restore_checkpoint(const InflateCheckpoint &p_checkpoint) const;
+	uint64_t _read_stored(uint8_t *p_dst, uint64_t p_length) const;
+	uint64_t _read_deflated(uint8_t *p_dst, uint64_t p_length) const;
 	void _close();
 
 public:
@@ -123,7 +163,7 @@ public:
 	virtual Error _set_read_only_attribute(const String &p_file, bool p_ro) override { return ERR_UNAVAILABLE; }
 	FileAccessAPK(const String &p_path);
 
-	FileAccessAPK(const String &p_path, const PackedData::PackedFile &p_file);
+	FileAccessAPK(const APKArchive *p_archive, const String &p_path);
 	~FileAccessAPK();
 };
 
@@ -0,0 +1,199 @@
+#include "file_access_encrypted_stream.h"
+
+Error FileAccessEncryptedStream::open_and_parse(Ref<FileAccess> p_base, const Vector<uint8_t> &p_key, bool p_verify) {
+	close();
+	ERR_FAIL_COND_V(p_base.is_null(), ERR_INVALID_PARAMETER);
+	ERR_FAIL_COND_V(p_key.size() != 32, ERR_INVALID_PARAMETER);
+
+	p_base->get_buffer(expected_md5, 16);
+	length = p_base->get_64();
+	p_base->get_buffer(iv, 16);
+	base = p_base->get_position();
+	ERR_FAIL_COND_V(p_base->get_length() < base + _get_padded_length(), ERR_FILE_CORRUPT);
+
+	// CFB uses the encryption key schedule in both directions.
+	ctx.set_encode_key(p_key.ptr(), 256);
+	md5_ctx.start();
+	md5_pos = 0;
+	file = p_base;
+	pos = 0;
+	eofed = false;
+	error = OK;
+	chunk_valid = false;
+	if (p_verify) {
+		Error err = _verify();
+		if (err != OK) {
+			close();
+			return err;
+		}
+	}
+	return OK;
+}
+
+// Decrypts every chunk in order so the MD5 is known before anything is handed out.
+Error FileAccessEncryptedStream::_verify() {
+	for (uint64_t ofs = 0; ofs < length; ofs += CHUNK_SIZE) {
+		Error err = _load_chunk(ofs);
+		if (err != OK) {
+			return err;
+		}
+	}
+	if (length == 0) {
+		unsigned char hash[16];
+		md5_ctx.finish(hash);
+		ERR_FAIL_COND_V(memcmp(hash, expected_md5, 16) != 0, ERR_FILE_CORRUPT);
+	}
+	return error;
+}
+
+uint64_t FileAccessEncryptedStream::_get_padded_length() const {
+	uint64_t padded_length = length;
+	if (padded_length % 16) {
+		padded_length += 16 - (padded_length % 16);
+	}
+	return padded_length;
+}
+
+Error FileAccessEncryptedStream::_decrypt_chunk(uint64_t p_start, LocalVector<uint8_t> &r_buf, uint64_t &r_len) const {
+	uint64_t enc_len = MIN(CHUNK_SIZE, _get_padded_length() - p_start);
+	r_buf.resize(enc_len);
+
+	uint8_t chunk_iv[16];
+	if (p_start == 0) {
+		memcpy(chunk_iv, iv, 16);
+		file->seek(base);
+	} else {
+		// The IV for a CFB block is the ciphertext block before it.
+		file->seek(base + p_start - 16);
+		ERR_FAIL_COND_V(file->get_buffer(chunk_iv, 16) != 16, ERR_FILE_CORRUPT);
+	}
+	ERR_FAIL_COND_V(file->get_buffer(r_buf.ptr(), enc_len) != enc_len, ERR_FILE_CORRUPT);
+	ERR_FAIL_COND_V(ctx.decrypt_cfb(enc_len, chunk_iv, r_buf.ptr(), r_buf.ptr()) != OK, ERR_FILE_CORRUPT);
+	r_len = MIN(enc_len, length - p_start);
+	return OK;
+}
+
+void FileAccessEncryptedStream::_decrypt_next_task(void *p_userdata) {
+	const FileAccessEncryptedStream *self = static_cast<const FileAccessEncryptedStream *>(p_userdata);
+	self->next_err = self->_decrypt_chunk(self->next_start, self->next_chunk, self->next_len);
+}
+
+// The read-ahead task uses the base file and the AES context, so wait for it before touching either.
+void FileAccessEncryptedStream::_wait_for_next() const {
+	if (next_task != WorkerThreadPool::INVALID_TASK_ID) {
+		WorkerThreadPool::get_singleton()->wait_for_task_completion(next_task);
+		next_task = WorkerThreadPool::INVALID_TASK_ID;
+	}
+}
+
+Error FileAccessEncryptedStream::_load_chunk(uint64_t p_position) const {
+	uint64_t start = p_position - (p_position % CHUNK_SIZE);
+	_wait_for_next();
+	if (next_len > 0 && next_start == start && next_err == OK) {
+		SWAP(chunk, next_chunk);
+		chunk_len = next_len;
+	} else {
+		Error err = _decrypt_chunk(start, chunk, chunk_len);
+		if (err != OK) {
+			chunk_valid = false;
+			return err;
+		}
+	}
+	next_len = 0;
+	chunk_start = start;
+	chunk_valid = true;
+	_update_md5();
+
+	// Decrypt the following chunk while the caller consumes this one.
+	if (start + CHUNK_SIZE < length) {
+		next_start = start + CHUNK_SIZE;
+		next_task = WorkerThreadPool::get_singleton()->add_native_task(&FileAccessEncryptedStream::_decrypt_next_task, (void *)this, false, "FileAccessEncryptedStream read-ahead");
+	}
+	return OK;
+}
+
+void FileAccessEncryptedStream::_update_md5() const {
+	if (chunk_start != md5_pos) {
+		return;
+	}
+	md5_ctx.update(chunk.ptr(), chunk_len);
+	md5_pos += chunk_len;
+	if (md5_pos == length) {
+		unsigned char hash[16];
+		md5_ctx.finish(hash);
+		if (memcmp(hash, expected_md5, 16) != 0) {
+			error = ERR_FILE_CORRUPT;
+			ERR_PRINT("The MD5 sum of the decrypted file does not match the expected value. It could be that the file is corrupt, or that the provided decryption key is invalid.");
+		}
+	}
+}
+
+String FileAccessEncryptedStream::get_path() const {
+	return file.is_valid() ? file->get_path() : String();
+}
+
+String FileAccessEncryptedStream::get_path_absolute() const {
+	return file.is_valid() ? file->get_path_absolute() : String();
+}
+
+void FileAccessEncryptedStream::seek(uint64_t p_position) {
+	pos = MIN(p_position, length);
+	eofed = false;
+}
+
+void FileAccessEncryptedStream::seek_end(int64_t p_position) {
+	seek(length + p_position);
+}
+
+uint8_t FileAccessEncryptedStream::get_8() const {
+	uint8_t b = 0;
+	get_buffer(&b, 1);
+	return b;
+}
+
+uint64_t FileAccessEncryptedStream::get_buffer(uint8_t *p_dst, uint64_t p_length) const {
+	ERR_FAIL_COND_V(!p_dst && p_length > 0, -1);
+	ERR_FAIL_COND_V(file.is_null(), -1);
+	uint64_t to_read = MIN(p_length, length - pos);
+	uint64_t done = 0;
+	while (done < to_read) {
+		if (!chunk_valid || pos < chunk_start || pos >= chunk_start + chunk_len) {
+			Error err = _load_chunk(pos);
+			if (err != OK) {
+				error = err;
+				break;
+			}
+		}
+		uint64_t n = MIN(to_read - done, chunk_start + chunk_len - pos);
+		memcpy(p_dst + done, chunk.ptr() + (pos - chunk_start), n);
+		done += n;
+		pos += n;
+	}
+	if (done < p_length) {
+		eofed = true;
+	}
+	return done;
+}
+
+Error FileAccessEncryptedStream::get_error() const {
+	if (error != OK) {
+		return error;
+	}
+	return eofed ? ERR_FILE_EOF : OK;
+}
+
+void FileAccessEncryptedStream::close() {
+	_wait_for_next();
+	next_chunk.clear();
+	next_len = 0;
+	file.unref();
+	chunk.clear();
+	chunk_valid = false;
+	length = 0;
+	pos = 0;
+	eofed = false;
+}
+
+FileAccessEncryptedStream::~FileAccessEncryptedStream() {
+	close();
+}
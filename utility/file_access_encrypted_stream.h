@@ -0,0 +1,95 @@
+#pragma once
+
+#include "core/crypto/crypto_core.h"
+#include "core/io/file_access.h"
+#include "core/object/worker_thread_pool.h"
+#include "core/templates/local_vector.h"
+
+// Read-only view of an AES-256-CFB encrypted pack entry (the Godot 4 FileAccessEncrypted layout, without the magic)
+// that decrypts one chunk at a time instead of the whole payload on open.
+// CFB only needs the previous ciphertext block as the IV, so any chunk can be decrypted on its own. While the consumer
+// works on one chunk, the next one is decrypted on the worker pool.
+// By default the MD5 is checked on open with a bounded-memory pass over the entry. Sequential consumers can skip that
+// and instead check get_error() after reading the whole entry in order.
+class FileAccessEncryptedStream : public FileAccess {
+	GDSOFTCLASS(FileAccessEncryptedStream, FileAccess);
+
+	static constexpr uint64_t CHUNK_SIZE = 256 * 1024; // Must be a multiple of the AES block size.
+
+	Ref<FileAccess> file;
+	mutable CryptoCore::AESContext ctx;
+	uint64_t base = 0;
+	uint64_t length = 0;
+	uint8_t iv[16] = {};
+	uint8_t expected_md5[16] = {};
+
+	mutable LocalVector<uint8_t> chunk;
+	mutable uint64_t chunk_start = 0;
+	mutable uint64_t chunk_len = 0;
+	mutable bool chunk_valid = false;
+	// Read-ahead of the chunk after the current one.
+	mutable LocalVector<uint8_t> next_chunk;
+	mutable uint64_t next_start = 0;
+	mutable uint64_t next_len = 0;
+	mutable Error next_err = OK;
+	mutable WorkerThreadPool::TaskID next_task = WorkerThreadPool::INVALID_TASK_ID;
+	mutable uint64_t pos = 0;
+	mutable bool eofed = false;
+	mutable Error error = OK;
+
+	// Running hash over chunks decrypted in order; chunks revisited after a seek are not hashed again.
+	mutable CryptoCore::MD5Context md5_ctx;
+	mutable uint64_t md5_pos = 0;
+
+	uint64_t _get_padded_length() const;
+	Error _decrypt_chunk(uint64_t p_start, LocalVector<uint8_t> &r_buf, uint64_t &r_len) const;
+	static void _decrypt_next_task(void *p_userdata);
+	void _wait_for_next() const;
+	Error _load_chunk(uint64_t p_position) const;
+	void _update_md5() const;
+	Error _verify();
+
+public:
+	Error open_and_parse(Ref<FileAccess> p_base, const Vector<uint8_t> &p_key, bool p_verify = true);
+
+	virtual Error open_internal(const String &p_path, int p_mode_flags) override { return ERR_UNAVAILABLE; }
+	virtual bool is_open() const override { return file.is_valid(); }
+
+	virtual String get_path() const override;
+	virtual String get_path_absolute() const override;
+
+	virtual void seek(uint64_t p_position) override;
+	virtual void seek_end(int64_t p_position = 0) override;
+	virtual uint64_t get_position() const override { return pos; }
+	virtual uint64_t get_length() const override { return length; }
+
+	virtual bool eof_reached() const override { return eofed; }
+
+	virtual uint8_t get_8() const override;
+	virtual uint64_t get_buffer(uint8_t *p_dst, uint64_t p_length) const override;
+
+	virtual Error get_error() const override;
+
+	virtual Error resize(int64_t p_length) override { return ERR_UNAVAILABLE; }
+	virtual void flush() override {}
+	virtual bool store_8(uint8_t p_dest) override { return false; }
+	virtual bool store_buffer(const uint8_t *p_src, uint64_t p_length) override { return false; }
+
+	virtual bool file_exists(const String &p_name) override { return false; }
+
+	virtual void close() override;
+	virtual uint64_t _get_access_time(const String &p_file) override { return 0; }
+	virtual int64_t _get_size(const String &p_file) override { return -1; }
+
+	virtual uint64_t _get_modified_time(const String &p_file) override { return 0; }
+	virtual BitField<FileAccess::UnixPermissionFlags> _get_unix_permissions(const String &p_file) override { return 0; }
+	virtual Error _set_unix_permissions(const String &p_file, BitField<FileAccess::UnixPermissionFlags> p_permissions) override { return FAILED; }
+
+	virtual bool _get_hidden_attribute(const String &p_file) override { return false; }
+	virtual Error _set_hidden_attribute(const String &p_file, bool p_hidden) override { return ERR_UNAVAILABLE; }
+	virtual bool _get_read_only_attribute(const String &p_file) override { return true; }
+	virtual Error _set_read_only_attribute(const String &p_file, bool p_ro) override { return ERR_UNAVAILABLE; }
+
+	FileAccessEncryptedStream() {}
+	~FileAccessEncryptedStream();
+};
@@ -5,6 +5,7 @@
 #include "file_access_gdre.h"
 #include "core/os/os.h"
 #include "file_access_apk.h"
+#include "file_access_mapped.h"
 #include "gdre_packed_source.h"
 #include "gdre_settings.h"
 #include "packed_file_info.h"
@@ -45,11 +46,21 @@ Ref<FileAccess> DirSource::get_file(const String &p_path, PackedData::PackedFile
 	return nullptr;
 }
 
-Error GDREPackedData::add_pack(const String &p_path, bool p_replace_files, uint64_t p_offset) {
+void GDREPackedData::_ensure_sources() {
 	if (sources.is_empty()) {
-		sources.push_back(memnew(GDREPackedSource));
+		pck_source = memnew(GDREPackedSource);
+		sources.push_back(pck_source);
 		sources.push_back(memnew(APKArchive));
 	}
+}
+
+void GDREPackedData::prefetch_packs(const Vector<String> &p_paths) {
+	_ensure_sources();
+	pck_source->prefetch_directories(p_paths);
+}
+
+Error GDREPackedData::add_pack(const String &p_path, bool p_replace_files, uint64_t p_offset) {
+	_ensure_sources();
 	for (int i = 0; i < sources.size(); i++) {
 		if (sources[i]->try_open_pack(p_path, p_replace_files, p_offset)) {
 			// need to set the default file access to use our own
@@ -79,50 +90,12 @@ void GDREPackedData::add_path(const String &p_pkg_path, const String &p_path, ui
 		pf.md5[i] = p_md5[i];
 	}
 	pf.src = p_src;
-	Ref<PackedFileInfo> pf_info;
-	pf_info.instantiate();
 	String abs_path = p_path.is_relative_path() ? "res://" + p_path : p_path;
-	pf_info->init(abs_path, &pf);
 
 	// Get the fixed path if this is from a PCK source
-	String path = p_pck_src ? pf_info->get_path() : p_path.simplify_path();
-
-	PathMD5 pmd5(path.trim_prefix("res://").md5_buffer());
-
-	bool exists = files.has(pmd5);
-
-	if (!exists || p_replace_files) {
-		files[pmd5] = pf;
-		file_map[path] = pf_info;
-	}
-
-	if (!exists) {
-		//search for dir
-		String p = path.trim_prefix("res://");
-		PackedDir *cd = root;
-
-		if (p.contains("/")) { //in a subdir
-
-			Vector<String> ds = p.get_base_dir().split("/");
-
-			for (int j = 0; j < ds.size(); j++) {
-				if (!cd->subdirs.has(ds[j])) {
-					PackedDir *pd = memnew(PackedDir);
-					pd->name = ds[j];
-					pd->parent = cd;
-					cd->subdirs[pd->name] = pd;
-					cd = pd;
-				} else {
-					cd = cd->subdirs[ds[j]];
-				}
-			}
-		}
-		String filename = path.get_file();
-		// Don't add as a file if the path points to a directory
-		if (!filename.is_empty()) {
-			cd->files.insert(filename);
-		}
-	}
+	bool malformed = false;
+	String path = p_pck_src ? PackedFileInfo::get_fixed_path(abs_path, malformed) : p_path;
+	index.insert(path, abs_path, malformed, pf, p_replace_files);
 }
 
 void GDREPackedData::add_pack_source(PackSource *p_source) {
@@ -132,87 +105,51 @@ void GDREPackedData::add_pack_source(PackSource *p_source) {
 }
 
 uint8_t *GDREPackedData::get_file_hash(const String &p_path) {
-	String simplified_path = p_path.simplify_path().trim_prefix("res://");
-	PathMD5 pmd5(simplified_path.md5_buffer());
-	HashMap<PathMD5, PackedData::PackedFile, PathMD5>::Iterator E = files.find(pmd5);
-	if (!E) {
+	int64_t idx = index.find(p_path);
+	if (idx < 0) {
 		return nullptr;
 	}
-
-	return E->value.md5;
+	return index.get_entry(idx).pf.md5;
 }
 
 HashSet<String> GDREPackedData::get_file_paths() const {
 	HashSet<String> file_paths;
-	_get_file_paths(root, root->name, file_paths);
-	return file_paths;
-}
-
-void GDREPackedData::_get_file_paths(PackedDir *p_dir, const String &p_parent_dir, HashSet<String> &r_paths) const {
-	for (const String &E : p_dir->files) {
-		r_paths.insert(p_parent_dir.path_join(E));
-	}
-
-	for (const KeyValue<String, PackedDir *> &E : p_dir->subdirs) {
-		_get_file_paths(E.value, p_parent_dir.path_join(E.key), r_paths);
+	for (uint32_t i = 0; i < index.size(); i++) {
+		const PackedPathIndex::Entry &e = index.get_entry(i);
+		if (!e.removed) {
+			file_paths.insert(index.get_path(e));
+		}
 	}
+	return file_paths;
 }
 
 GDREPackedData *GDREPackedData::singleton = nullptr;
 
 GDREPackedData::GDREPackedData() {
 	singleton = this;
-	root = memnew(PackedDir);
 }
 
 Vector<Ref<PackedFileInfo>> GDREPackedData::get_file_info_list(const Vector<String> &filters) {
 	Vector<Ref<PackedFileInfo>> ret;
-	bool no_filters = !filters.size();
-	for (auto E : file_map) {
-		if (no_filters) {
-			ret.push_back(E.value);
-			continue;
-		}
-		for (int j = 0; j < filters.size(); j++) {
-			if (E.key.get_file().match(filters[j])) {
-				ret.push_back(E.value);
-				break;
+	if (!filters.size()) {
+		for (uint32_t i = 0; i < index.size(); i++) {
+			if (!index.get_entry(i).removed) {
+				ret.push_back(index.get_file_info(i));
 			}
 		}
+		return ret;
+	}
+	LocalVector<uint32_t> matches;
+	index.query_files(filters, matches);
+	ret.resize(matches.size());
+	for (uint32_t i = 0; i < matches.size(); i++) {
+		ret.write[i] = index.get_file_info(matches[i]);
 	}
 	return ret;
 }
 
 void GDREPackedData::remove_path(const String &p_path) {
-	String simplified_path = p_path.simplify_path().trim_prefix("res://");
-
-	PathMD5 pmd5(simplified_path.md5_buffer());
-	if (!files.has(pmd5)) {
-		return;
-	}
-
-	// Search for directory.
-	PackedDir *cd = root;
-
-	if (simplified_path.contains_char('/')) { // In a subdirectory.
-		Vector<String> ds = simplified_path.get_base_dir().split("/");
-
-		for (int j = 0; j < ds.size(); j++) {
-			if (!cd->subdirs.has(ds[j])) {
-				return; // Subdirectory does not exist, do not bother creating.
-			} else {
-				cd = cd->subdirs[ds[j]];
-			}
-		}
-	}
-
-	if (file_map.has(p_path.simplify_path())) {
-		file_map.erase(p_path.simplify_path());
-	}
-
-	cd->files.erase(simplified_path.get_file());
-
-	files.erase(pmd5);
+	index.remove(p_path);
 }
 
 void GDREPackedData::set_disabled(bool p_disabled) {
@@ -242,34 +179,99 @@ GDREPackedData *GDREPackedData::get_singleton() {
 }
 
 int64_t GDREPackedData::get_file_size(const String &p_path) {
-	String simplified_path = p_path.simplify_path().trim_prefix("res://");
-	PathMD5 pmd5(simplified_path.md5_buffer());
-	HashMap<PathMD5, PackedData::PackedFile, PathMD5>::Iterator E = files.find(pmd5);
-	if (!E) {
+	int64_t idx = index.find(p_path);
+	if (idx < 0) {
+		return -1; //not found
+	}
+	const PackedData::PackedFile &pf = index.get_entry(idx).pf;
+	if (pf.offset == 0) {
+		return -1; //was erased
+	}
+	return pf.size;
+}
+
+int64_t GDREPackedData::get_file_offset(const String &p_path) {
+	int64_t idx = index.find(p_path);
+	if (idx < 0) {
 		return -1; //not found
 	}
-	if (E->value.offset == 0) {
+	const PackedData::PackedFile &pf = index.get_entry(idx).pf;
+	if (pf.offset == 0) {
 		return -1; //was erased
 	}
-	return E->value.size;
+	return pf.offset;
+}
+
+bool GDREPackedData::get_io_locality(const String &p_path, String &r_pack, uint64_t &r_offset) {
+	int64_t idx = index.find(p_path);
+	if (idx < 0 || index.get_entry(idx).removed) {
+		return false;
+	}
+	const PackedData::PackedFile &pf = index.get_entry(idx).pf;
+	r_pack = pf.pack;
+	r_offset = pf.offset;
+	return true;
+}
+
+bool GDREPackedData::is_raw_pack_entry(const PackedData::PackedFile &p_file) const {
+	return pck_source && p_file.src == pck_source && !p_file.encrypted;
+}
+
+void GDREPackedData::release_pack_mapping(const String &p_pack_path) {
+	if (pck_source) {
+		pck_source->release_mapping(p_pack_path);
+	}
+}
+
+bool GDREPackedData::get_pck_entry(const String &p_path, PackedData::PackedFile &r_file) {
+	int64_t idx = index.find(p_path);
+	if (idx < 0 || index.get_entry(idx).removed) {
+		return false;
+	}
+	const PackedData::PackedFile &pf = index.get_entry(idx).pf;
+	if (!pck_source || pf.src != pck_source) {
+		return false;
+	}
+	r_file = pf;
+	return true;
+}
+
+void GDREPackedData::prefetch_file(const PackedData::PackedFile &p_file) {
+	if (pck_source && p_file.src == pck_source) {
+		pck_source->prefetch_range(p_file.pack, p_file.offset, p_file.size);
+	}
 }
 
 Ref<FileAccess> GDREPackedData::try_open_path(const String &p_path) {
-	String simplified_path = p_path.simplify_path().trim_prefix("res://");
-	PathMD5 pmd5(simplified_path.md5_buffer());
-	HashMap<PathMD5, PackedData::PackedFile, PathMD5>::Iterator E = files.find(pmd5);
-	if (!E) {
+	int64_t idx = index.find(p_path);
+	if (idx < 0) {
 		return nullptr; //not found
 	}
-	if (E->value.offset == 0) {
+	PackedData::PackedFile &pf = index.get_entry(idx).pf;
+	if (pf.offset == 0) {
 		return nullptr; //was erased
 	}
 
-	return E->value.src->get_file(p_path, &E->value);
+	return pf.src->get_file(p_path, &pf);
+}
+
+Ref<FileAccess> GDREPackedData::open_sequential(const String &p_path) {
+	int64_t idx = index.find(p_path);
+	if (idx < 0) {
+		return nullptr; //not found
+	}
+	PackedData::PackedFile &pf = index.get_entry(idx).pf;
+	if (pf.offset == 0) {
+		return nullptr; //was erased
+	}
+	if (pck_source && pf.src == pck_source) {
+		return pck_source->get_file_sequential(p_path, &pf);
+	}
+	return pf.src->get_file(p_path, &pf);
 }
 
 bool GDREPackedData::has_path(const String &p_path) {
-	return files.has(PathMD5(p_path.simplify_path().trim_prefix("res://").md5_buffer()));
+	return index.has(p_path);
 }
 
 Ref<DirAccess> GDREPackedData::try_open_directory(const String &p_path) {
@@ -287,15 +289,8 @@ bool GDREPackedData::has_directory(const String &p_path) {
 	}
 	return false;
 }
-void GDREPackedData::_free_packed_dirs(GDREPackedData::PackedDir *p_dir) {
-	for (const KeyValue<String, PackedDir *> &E : p_dir->subdirs) {
-		_free_packed_dirs(E.value);
-	}
-	memdelete(p_dir);
-}
-
 bool GDREPackedData::has_loaded_packs() {
-	return !sources.is_empty() && !files.is_empty();
+	return !sources.is_empty() && !index.is_empty();
 }
 
 // Test for the existence of project.godot or project.binary in the packed data
@@ -314,18 +309,13 @@ void GDREPackedData::_clear() {
 		memdelete(sources[i]);
 	}
 	sources.clear();
+	pck_source = nullptr;
 	set_disabled(true);
-	_free_packed_dirs(root);
-	root = memnew(PackedDir);
-	file_map.clear();
-	files.clear();
+	index.clear();
 }
 
 GDREPackedData::~GDREPackedData() {
 	_clear();
-	if (root) {
-		_free_packed_dirs(root);
-	}
 }
 
 bool is_gdre_file(const String &p_path) {
@@ -333,6 +323,66 @@ bool is_gdre_file(const String &p_path) {
 }
 
 Error FileAccessGDRE::open_internal(const String &p_path, int p_mode_flags) {
+	_reset_read_buffer();
+	Error err = _open_proxy(p_path, p_mode_flags);
+	// Mapped files are already plain memory reads, so there's nothing to gain from buffering those.
+	read_buffered = err == OK && !(p_mode_flags & WRITE) && !Object::cast_to<FileAccessMapped>(proxy.ptr());
+	return err;
+}
+
+void FileAccessGDRE::_reset_read_buffer() {
+	read_buffered = false;
+	read_buffer.clear();
+	read_buffer_start = 0;
+	read_buffer_len = 0;
+	read_pos = 0;
+	proxy_pos = 0;
+	read_eof = false;
+}
+
+uint64_t FileAccessGDRE::_buffered_read(uint8_t *p_dst, uint64_t p_length) const {
+	uint64_t copied = 0;
+	if (read_pos >= read_buffer_start && read_pos < read_buffer_start + read_buffer_len) {
+		copied = MIN(p_length, read_buffer_start + read_buffer_len - read_pos);
+		memcpy(p_dst, read_buffer.ptr() + (read_pos - read_buffer_start), copied);
+		read_pos += copied;
+		if (copied == p_length) {
+			return copied;
+		}
+	}
+	if (proxy_pos != read_pos) {
+		proxy->seek(read_pos);
+		proxy_pos = read_pos;
+	}
+	uint64_t remaining = p_length - copied;
+	if (remaining >= READ_BUFFER_SIZE) {
+		// Large reads go straight to the destination.
+		uint64_t got = proxy->get_buffer(p_dst + copied, remaining);
+		read_pos += got;
+		proxy_pos = read_pos;
+		read_buffer_len = 0;
+		if (got < remaining) {
+			read_eof = true;
+		}
+		return copied + got;
+	}
+	if (read_buffer.is_empty()) {
+		read_buffer.resize(MAX((uint64_t)1, MIN(READ_BUFFER_SIZE, proxy->get_length())));
+	}
+	uint64_t got = proxy->get_buffer(read_buffer.ptr(), read_buffer.size());
+	read_buffer_start = read_pos;
+	read_buffer_len = got;
+	proxy_pos = read_pos + got;
+	uint64_t n = MIN(remaining, got);
+	memcpy(p_dst + copied, read_buffer.ptr(), n);
+	read_pos += n;
+	if (n < remaining) {
+		read_eof = true;
+	}
+	return copied + n;
+}
+
+Error FileAccessGDRE::_open_proxy(const String &p_path, int p_mode_flags) {
 	//try packed data first
 	if (!(p_mode_flags & WRITE) && GDREPackedData::get_singleton() && !GDREPackedData::get_singleton()->is_disabled()) {
 		proxy = GDREPackedData::get_singleton()->try_open_path(p_path);
@@ -373,16 +423,29 @@ bool FileAccessGDRE::is_open() const {
 
 void FileAccessGDRE::seek(uint64_t p_position) {
 	ERR_FAIL_COND_MSG(proxy.is_null(), "File must be opened before use.");
+	if (read_buffered) {
+		// The proxy catches up on the next read that misses the buffer.
+		read_pos = p_position;
+		read_eof = false;
+		return;
+	}
 	proxy->seek(p_position);
 }
 
 void FileAccessGDRE::seek_end(int64_t p_position) {
 	ERR_FAIL_COND_MSG(proxy.is_null(), "File must be opened before use.");
+	if (read_buffered) {
+		seek(proxy->get_length() + p_position);
+		return;
+	}
 	proxy->seek_end(p_position);
 }
 
 uint64_t FileAccessGDRE::get_position() const {
 	ERR_FAIL_COND_V_MSG(proxy.is_null(), 0, "File must be opened before use.");
+	if (read_buffered) {
+		return read_pos;
+	}
 	return proxy->get_position();
 }
 
@@ -393,22 +456,46 @@ uint64_t FileAccessGDRE::get_length() const {
 
 bool FileAccessGDRE::eof_reached() const {
 	ERR_FAIL_COND_V_MSG(proxy.is_null(), true, "File must be opened before use.");
+	if (read_buffered) {
+		return read_eof;
+	}
 	return proxy->eof_reached();
 }
 
 uint8_t FileAccessGDRE::get_8() const {
 	ERR_FAIL_COND_V_MSG(proxy.is_null(), 0, "File must be opened before use.");
+	if (read_buffered) {
+		if (read_pos >= read_buffer_start && read_pos < read_buffer_start + read_buffer_len) {
+			return read_buffer[read_pos++ - read_buffer_start];
+		}
+		uint8_t b = 0;
+		_buffered_read(&b, 1);
+		return b;
+	}
 	return proxy->get_8();
 }
 
 uint64_t FileAccessGDRE::get_buffer(uint8_t *p_dst, uint64_t p_length) const {
 	ERR_FAIL_COND_V_MSG(proxy.is_null(), -1, "File must be opened before use.");
+	if (read_buffered) {
+		ERR_FAIL_COND_V(!p_dst && p_length > 0, -1);
+		return _buffered_read(p_dst, p_length);
+	}
 	return proxy->get_buffer(p_dst, p_length);
 }
 
 Error FileAccessGDRE::get_error() const {
 	ERR_FAIL_COND_V_MSG(proxy.is_null(), ERR_FILE_NOT_FOUND, "File must be opened before use.");
-	return proxy->get_error();
+	Error err = proxy->get_error();
+	// Real errors (read failures, checksum mismatches) win over the EOF bookkeeping below.
+	if (err != OK && err != ERR_FILE_EOF) {
+		return err;
+	}
+	if (read_buffered) {
+		// Read-ahead can run the proxy into EOF before the caller gets there.
+		return read_eof ? ERR_FILE_EOF : OK;
+	}
+	return err;
 }
 
 Error FileAccessGDRE::resize(int64_t p_length) {
@@ -448,6 +535,7 @@ bool FileAccessGDRE::file_exists(const String &p_name) {
 }
 
 void FileAccessGDRE::close() {
+	_reset_read_buffer();
 	if (proxy.is_null()) {
 		return;
 	}
@@ -530,19 +618,13 @@ Error DirAccessGDRE::list_dir_begin() {
 	if (proxy.is_valid()) {
 		return proxy->list_dir_begin();
 	}
-	if (!current) {
+	if (!is_current_valid) {
 		return ERR_UNCONFIGURED;
 	}
 	list_dirs.clear();
 	list_files.clear();
 
-	for (const KeyValue<String, GDREPackedData::PackedDir *> &E : current->subdirs) {
-		list_dirs.push_back(E.key);
-	}
-
-	for (const String &E : current->files) {
-		list_files.push_back(E);
-	}
+	GDREPackedData::get_singleton()->index.list_dir(current, list_dirs, list_files);
 
 	return OK;
 }
@@ -620,15 +702,19 @@ bool DirAccessGDRE::drives_are_shortcuts() {
 }
 
 // internal method
-GDREPackedData::PackedDir *DirAccessGDRE::_find_dir(String p_dir) {
-	if (!current) {
-		return nullptr;
+bool DirAccessGDRE::_find_dir(String p_dir, String &r_dir) {
+	if (!is_current_valid) {
+		return false;
 	}
 	String nd = p_dir.replace("\\", "/");
 
 	// Special handling since simplify_path() will forbid it
 	if (p_dir == "..") {
-		return current->parent;
+		if (current.is_empty()) {
+			return false;
+		}
+		r_dir = current.get_base_dir();
+		return true;
 	}
 
 	bool absolute = false;
@@ -650,42 +736,35 @@ GDREPackedData::PackedDir *DirAccessGDRE::_find_dir(String p_dir) {
 
 	Vector<String> paths = nd.split("/");
 
-	GDREPackedData::PackedDir *pd;
-
-	if (absolute) {
-		pd = GDREPackedData::get_singleton()->root;
-	} else {
-		pd = current;
-	}
+	String pd = absolute ? String() : current;
 
 	for (int i = 0; i < paths.size(); i++) {
-		String p = paths[i];
-		if (p == ".") {
+		const String &p = paths[i];
+		if (p == "." || p.is_empty()) {
 			continue;
 		} else if (p == "..") {
-			if (pd->parent) {
-				pd = pd->parent;
-			}
-		} else if (pd->subdirs.has(p)) {
-			pd = pd->subdirs[p];
-
+			pd = pd.get_base_dir();
 		} else {
-			return nullptr;
+			pd = pd.is_empty() ? p : pd + "/" + p;
+			if (!GDREPackedData::get_singleton()->index.has_dir(pd)) {
+				return false;
+			}
 		}
 	}
 
-	return pd;
+	r_dir = pd;
+	return true;
 }
 
 Error DirAccessGDRE::change_dir(String p_dir) {
 	if (proxy.is_valid()) {
 		return proxy->change_dir(p_dir);
 	}
-	if (!current) {
+	if (!is_current_valid) {
 		return ERR_UNCONFIGURED;
 	}
-	GDREPackedData::PackedDir *pd = _find_dir(p_dir);
-	if (pd) {
+	String pd;
+	if (_find_dir(p_dir, pd)) {
 		current = pd;
 		return OK;
 	} else {
@@ -697,18 +776,10 @@ String DirAccessGDRE::get_current_dir(bool p_include_drive) const {
 	if (proxy.is_valid()) {
 		return proxy->get_current_dir(p_include_drive);
 	}
-	if (!current) {
+	if (!is_current_valid) {
 		return "";
 	}
-	GDREPackedData::PackedDir *pd = current;
-	String p = current->name;
-
-	while (pd->parent) {
-		pd = pd->parent;
-		p = pd->name.path_join(p);
-	}
-
-	return "res://" + p;
+	return "res://" + current;
 }
 
 bool DirAccessGDRE::file_exists(String p_file) {
@@ -717,11 +788,12 @@ bool DirAccessGDRE::file_exists(String p_file) {
 	}
 	p_file = fix_path(p_file);
 
-	GDREPackedData::PackedDir *pd = _find_dir(p_file.get_base_dir());
-	if (!pd) {
+	String pd;
+	if (!_find_dir(p_file.get_base_dir(), pd)) {
 		return false;
 	}
-	return pd->files.has(p_file.get_file());
+	String file = p_file.get_file();
+	return GDREPackedData::get_singleton()->index.has(pd.is_empty() ? file : pd + "/" + file);
 }
 
 bool DirAccessGDRE::dir_exists(String p_dir) {
@@ -730,7 +802,8 @@ bool DirAccessGDRE::dir_exists(String p_dir) {
 	}
 	p_dir = fix_path(p_dir);
 
-	return _find_dir(p_dir) != nullptr;
+	String pd;
+	return _find_dir(p_dir, pd);
 }
 
 bool DirAccessGDRE::is_readable(String p_dir) {
@@ -818,9 +891,10 @@ Error DirAccessGDRE::create_link(String p_source, String p_target) {
 DirAccessGDRE::DirAccessGDRE() {
 	if (GDREPackedData::get_singleton()->is_disabled() || !GDREPackedData::get_singleton()->has_loaded_packs()) {
 		proxy = _open_filesystem();
-		current = nullptr;
+		is_current_valid = false;
 	} else {
-		current = GDREPackedData::get_singleton()->root;
+		current = String();
+		is_current_valid = true;
 		proxy = Ref<DirAccess>();
 	}
 }
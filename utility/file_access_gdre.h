@@ -4,6 +4,9 @@
 #include "core/io/file_access.h"
 #include "core/io/file_access_pack.h"
 #include "utility/packed_file_info.h"
+#include "utility/packed_path_index.h"
+
+class GDREPackedSource;
 
 class DirSource : public PackSource {
 public:
@@ -16,41 +19,11 @@ class GDREPackedData {
 	friend class DirAccessGDRE;
 	friend class PackSource;
 
-public:
-	struct PackedDir {
-		PackedDir *parent = nullptr;
-		String name;
-		HashMap<String, PackedDir *> subdirs;
-		HashSet<String> files;
-	};
-
-	struct PathMD5 {
-		uint64_t a = 0;
-		uint64_t b = 0;
-
-		bool operator==(const PathMD5 &p_val) const {
-			return (a == p_val.a) && (b == p_val.b);
-		}
-		static uint32_t hash(const PathMD5 &p_val) {
-			uint32_t h = hash_murmur3_one_32(p_val.a);
-			return hash_fmix32(hash_murmur3_one_32(p_val.b, h));
-		}
-
-		PathMD5() {}
-
-		explicit PathMD5(const Vector<uint8_t> &p_buf) {
-			a = *((uint64_t *)&p_buf[0]);
-			b = *((uint64_t *)&p_buf[8]);
-		}
-	};
-
 private:
-	HashMap<PathMD5, PackedData::PackedFile, PathMD5> files;
-	HashMap<String, Ref<PackedFileInfo>> file_map;
+	PackedPathIndex index;
 
 	Vector<PackSource *> sources;
-
-	PackedDir *root = nullptr;
+	GDREPackedSource *pck_source = nullptr;
 
 	DirSource dir_source;
 
@@ -60,10 +33,8 @@ private:
 	String old_dir_access_class;
 	bool set_file_access_defaults = false;
 
-	void _free_packed_dirs(PackedDir *p_dir);
-	void _get_file_paths(PackedDir *p_dir, const String &p_parent_dir, HashSet<String> &r_paths) const;
-
 	void _clear();
+	void _ensure_sources();
 
 public:
 	void set_default_file_access();
@@ -78,12 +49,16 @@ public:
 	_FORCE_INLINE_ bool is_disabled() const;
 
 	static GDREPackedData *get_singleton();
+	// Parses the directories of the given PCK files in parallel ahead of add_pack.
+	void prefetch_packs(const Vector<String> &p_paths);
 	Error add_pack(const String &p_path, bool p_replace_files, uint64_t p_offset);
 	Error add_dir(const String &p_path, bool p_replace_files = false);
 
 	void clear();
 
 	_FORCE_INLINE_ Ref<FileAccess> try_open_path(const String &p_path);
+	// Like try_open_path, for readers that consume the whole file in order and then check get_error().
+	Ref<FileAccess> open_sequential(const String &p_path);
 	bool has_path(const String &p_path);
 
 	_FORCE_INLINE_ Ref<DirAccess> try_open_directory(const String &p_path);
@@ -94,6 +69,17 @@ public:
 	bool has_loaded_packs();
 	String fix_res_path(const String &p_path);
 	int64_t get_file_size(const String &p_path);
+	int64_t get_file_offset(const String &p_path);
+	// Pack path and offset of p_path, for ordering reads; false if it isn't in the index.
+	bool get_io_locality(const String &p_path, String &r_pack, uint64_t &r_offset);
+	// True for unencrypted entries of a PCK, whose bytes in the pack file are the file contents.
+	bool is_raw_pack_entry(const PackedData::PackedFile &p_file) const;
+	// Entry for p_path if it is stored in a PCK (encrypted or not); false for other sources or missing paths.
+	bool get_pck_entry(const String &p_path, PackedData::PackedFile &r_file);
+	// Releases the memory mapping of a loaded pack file before it is written to.
+	void release_pack_mapping(const String &p_pack_path);
+	// Hints that p_file will be read soon.
+	void prefetch_file(const PackedData::PackedFile &p_file);
 	static String get_current_file_access_class(FileAccess::AccessType p_access_type);
 	static String get_current_dir_access_class(DirAccess::AccessType p_access_type);
 	static String get_os_file_access_class_name();
@@ -117,6 +103,21 @@ class FileAccessGDRE : public FileAccess {
 	virtual bool _get_hidden_attribute(const String &p_file) override;
 
 	static Ref<FileAccess> _open_filesystem(const String &p_path, int p_mode_flags, Error *r_error);
+	Error _open_proxy(const String &p_path, int p_mode_flags);
+
+	// Read-ahead block for read-only files, so field-by-field readers don't hit the proxy for every few bytes.
+	// When active, `read_pos` is the logical position and the proxy's own position is only moved on refills.
+	static constexpr uint64_t READ_BUFFER_SIZE = 16 * 1024;
+	bool read_buffered = false;
+	mutable LocalVector<uint8_t> read_buffer;
+	mutable uint64_t read_buffer_start = 0;
+	mutable uint64_t read_buffer_len = 0;
+	mutable uint64_t read_pos = 0;
+	mutable uint64_t proxy_pos = 0;
+	mutable bool read_eof = false;
+
+	void _reset_read_buffer();
+	uint64_t _buffered_read(uint8_t *p_dst, uint64_t p_length) const;
 
 public:
 	virtual Error open_internal(const String &p_path, int p_mode_flags) override; ///< open a file
@@ -144,17 +145,21 @@ public:
 	virtual bool file_exists(const String &p_name) override; ///< return true if a file exists
 
 	virtual void close() override;
+
+	Ref<FileAccess> get_proxy() const { return proxy; }
 };
 
 class DirAccessGDRE : public DirAccess {
 	GDSOFTCLASS(DirAccessGDRE, DirAccess);
-	GDREPackedData::PackedDir *current;
+	// Canonical path of the current directory relative to res://; only meaningful when is_current_valid.
+	String current;
+	bool is_current_valid = false;
 
 	List<String> list_dirs;
 	List<String> list_files;
 	bool cdir = false;
 
-	GDREPackedData::PackedDir *_find_dir(String p_dir);
+	bool _find_dir(String p_dir, String &r_dir);
 
 	Ref<DirAccess> proxy;
 
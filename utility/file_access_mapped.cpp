@@ -0,0 +1,201 @@
+#include "file_access_mapped.h"
+
+#include "core/config/project_settings.h"
+#include "utility/file_access_gdre.h"
+
+#ifdef WINDOWS_ENABLED
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined(UNIX_ENABLED)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool PackMapping::is_supported() {
+#if defined(WINDOWS_ENABLED) || defined(UNIX_ENABLED)
+	// Multi-GB packs won't fit in a 32-bit address space; just read those through FileAccess.
+	return sizeof(void *) >= 8;
+#else
+	return false;
+#endif
+}
+
+Ref<PackMapping> PackMapping::map_file(const String &p_path) {
+	if (!is_supported()) {
+		return Ref<PackMapping>();
+	}
+	String os_path = ProjectSettings::get_singleton() ? ProjectSettings::get_singleton()->globalize_path(p_path) : p_path;
+	Ref<PackMapping> mapping;
+	mapping.instantiate();
+	mapping->path = p_path;
+#ifdef WINDOWS_ENABLED
+	HANDLE file = CreateFileW((LPCWSTR)os_path.utf16().get_data(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return Ref<PackMapping>();
+	}
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart <= 0) {
+		CloseHandle(file);
+		return Ref<PackMapping>();
+	}
+	HANDLE map = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!map) {
+		CloseHandle(file);
+		return Ref<PackMapping>();
+	}
+	void *view = MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+	if (!view) {
+		CloseHandle(map);
+		CloseHandle(file);
+		return Ref<PackMapping>();
+	}
+	mapping->file_handle = file;
+	mapping->mapping_handle = map;
+	mapping->data = (const uint8_t *)view;
+	mapping->size = file_size.QuadPart;
+#elif defined(UNIX_ENABLED)
+	int fd = ::open(os_path.utf8().get_data(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return Ref<PackMapping>();
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+		::close(fd);
+		return Ref<PackMapping>();
+	}
+	void *view = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	// The mapping holds its own reference to the file.
+	::close(fd);
+	if (view == MAP_FAILED) {
+		return Ref<PackMapping>();
+	}
+	mapping->data = (const uint8_t *)view;
+	mapping->size = st.st_size;
+#endif
+	return mapping;
+}
+
+Span<uint8_t> PackMapping::get_range(uint64_t p_offset, uint64_t p_length) const {
+	ERR_FAIL_COND_V(!data || !has_range(p_offset, p_length), Span<uint8_t>());
+	return Span<uint8_t>(data + p_offset, p_length);
+}
+
+void PackMapping::advise(uint64_t p_offset, uint64_t p_length, AccessHint p_hint) const {
+#if defined(__linux__)
+	if (!data || !has_range(p_offset, p_length) || p_length == 0) {
+		return;
+	}
+	static const uint64_t page_size = sysconf(_SC_PAGESIZE);
+	uint64_t start = p_offset - (p_offset % page_size);
+	int advice = MADV_NORMAL;
+	switch (p_hint) {
+		case ACCESS_RANDOM:
+			advice = MADV_RANDOM;
+			break;
+		case ACCESS_SEQUENTIAL:
+			advice = MADV_SEQUENTIAL;
+			break;
+		case ACCESS_WILLNEED:
+			advice = MADV_WILLNEED;
+			break;
+	}
+	madvise((void *)(data + start), p_offset + p_length - start, advice);
+#endif
+}
+
+void PackMapping::_unmap() {
+	if (!data) {
+		return;
+	}
+#ifdef WINDOWS_ENABLED
+	UnmapViewOfFile(data);
+	CloseHandle((HANDLE)mapping_handle);
+	CloseHandle((HANDLE)file_handle);
+	mapping_handle = nullptr;
+	file_handle = nullptr;
+#elif defined(UNIX_ENABLED)
+	munmap((void *)data, size);
+#endif
+	data = nullptr;
+	size = 0;
+}
+
+PackMapping::~PackMapping() {
+	_unmap();
+}
+
+Error FileAccessMapped::open_range(const Ref<PackMapping> &p_mapping, uint64_t p_offset, uint64_t p_length, bool p_sequential) {
+	close();
+	ERR_FAIL_COND_V(p_mapping.is_null(), ERR_INVALID_PARAMETER);
+	ERR_FAIL_COND_V_MSG(!p_mapping->has_range(p_offset, p_length), ERR_FILE_CORRUPT, "File range is outside of pack " + p_mapping->get_path());
+	mapping = p_mapping;
+	data = p_mapping->get_data() + p_offset;
+	length = p_length;
+	opened = true;
+	if (p_sequential) {
+		// Read front to back once (extraction, hashing): read ahead aggressively over the whole entry.
+		mapping->advise(p_offset, p_length, PackMapping::ACCESS_SEQUENTIAL);
+	}
+	// At least the start of the file is about to be read.
+	mapping->advise(p_offset, MIN(p_length, OPEN_WILLNEED_LENGTH), PackMapping::ACCESS_WILLNEED);
+	return OK;
+}
+
+bool FileAccessMapped::get_span_for(const Ref<FileAccess> &p_file, Span<uint8_t> &r_span) {
+	Ref<FileAccess> f = p_file;
+	Ref<FileAccessGDRE> gdre_file = f;
+	if (gdre_file.is_valid()) {
+		f = gdre_file->get_proxy();
+	}
+	Ref<FileAccessMapped> mapped = f;
+	if (mapped.is_null() || !mapped->is_open()) {
+		return false;
+	}
+	r_span = mapped->get_span();
+	return true;
+}
+
+void FileAccessMapped::seek(uint64_t p_position) {
+	pos = MIN(p_position, length);
+	at_eof = false;
+}
+
+void FileAccessMapped::seek_end(int64_t p_position) {
+	seek(length + p_position);
+}
+
+uint8_t FileAccessMapped::get_8() const {
+	if (pos >= length) {
+		at_eof = true;
+		return 0;
+	}
+	return data[pos++];
+}
+
+uint64_t FileAccessMapped::get_buffer(uint8_t *p_dst, uint64_t p_length) const {
+	ERR_FAIL_COND_V(!p_dst && p_length > 0, -1);
+	uint64_t to_read = MIN(p_length, length - pos);
+	if (to_read > 0) {
+		memcpy(p_dst, data + pos, to_read);
+		pos += to_read;
+	}
+	if (to_read < p_length) {
+		at_eof = true;
+	}
+	return to_read;
+}
+
+void FileAccessMapped::close() {
+	mapping.unref();
+	data = nullptr;
+	length = 0;
+	pos = 0;
+	at_eof = false;
+	opened = false;
+}
+
+FileAccessMapped::~FileAccessMapped() {
+	close();
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "core/io/file_access.h"
+#include "core/object/ref_counted.h"
+#include "core/templates/span.h"
+
+// A read-only memory mapping of a whole pack file. Views keep the mapping alive, so it outlives the pack source.
+class PackMapping : public RefCounted {
+	GDSOFTCLASS(PackMapping, RefCounted);
+
+	String path;
+	const uint8_t *data = nullptr;
+	uint64_t size = 0;
+#ifdef WINDOWS_ENABLED
+	void *file_handle = nullptr;
+	void *mapping_handle = nullptr;
+#endif
+
+	void _unmap();
+
+public:
+	enum AccessHint {
+		ACCESS_RANDOM,
+		ACCESS_SEQUENTIAL,
+		ACCESS_WILLNEED,
+	};
+
+	static bool is_supported();
+	static Ref<PackMapping> map_file(const String &p_path);
+
+	String get_path() const { return path; }
+	uint64_t get_size() const { return size; }
+	const uint8_t *get_data() const { return data; }
+	bool has_range(uint64_t p_offset, uint64_t p_length) const { return p_offset <= size && p_length <= size - p_offset; }
+	Span<uint8_t> get_range(uint64_t p_offset, uint64_t p_length) const;
+
+	// No-op where the platform has no madvise.
+	void advise(uint64_t p_offset, uint64_t p_length, AccessHint p_hint) const;
+
+	~PackMapping();
+};
+
+// Read-only FileAccess over a range of a PackMapping; reads are plain memcpys with no syscalls.
+class FileAccessMapped : public FileAccess {
+	GDSOFTCLASS(FileAccessMapped, FileAccess);
+
+	Ref<PackMapping> mapping;
+	const uint8_t *data = nullptr;
+	uint64_t length = 0;
+	bool opened = false;
+	mutable uint64_t pos = 0;
+	mutable bool at_eof = false;
+
+	// Read ahead on open only this much; many opens just sniff a header, and the kernel's fault readahead covers
+	// files that are read further.
+	static constexpr uint64_t OPEN_WILLNEED_LENGTH = 64 * 1024;
+
+public:
+	// With p_sequential, the range is hinted for sequential reading as a whole.
+	Error open_range(const Ref<PackMapping> &p_mapping, uint64_t p_offset, uint64_t p_length, bool p_sequential = false);
+
+	// Direct view of the whole file, for callers that can avoid copying through get_buffer.
+	Span<uint8_t> get_span() const { return Span<uint8_t>(data, length); }
+	static bool get_span_for(const Ref<FileAccess> &p_file, Span<uint8_t> &r_span);
+
+	virtual Error open_internal(const String &p_path, int p_mode_flags) override { return ERR_UNAVAILABLE; }
+	virtual bool is_open() const override { return opened; }
+
+	virtual void seek(uint64_t p_position) override;
+	virtual void seek_end(int64_t p_position = 0) override;
+	virtual uint64_t get_position() const override { return pos; }
+	virtual uint64_t get_length() const override { return length; }
+
+	virtual bool eof_reached() const override { return at_eof; }
+
+	virtual uint8_t get_8() const override;
+	virtual uint64_t get_buffer(uint8_t *p_dst, uint64_t p_length) const override;
+
+	virtual Error get_error() const override { return at_eof ? ERR_FILE_EOF : OK; }
+
+	virtual Error resize(int64_t p_length) override { return ERR_UNAVAILABLE; }
+	virtual void flush() override {}
+	virtual bool store_8(uint8_t p_dest) override { return false; }
+	virtual bool store_buffer(const uint8_t *p_src, uint64_t p_length) override { return false; }
+
+	virtual bool file_exists(const String &p_name) override { return false; }
+
+	virtual void close() override;
+	virtual uint64_t _get_access_time(const String &p_file) override { return 0; }
+	virtual int64_t _get_size(const String &p_file) override { return -1; }
+
+	virtual uint64_t _get_modified_time(const String &p_file) override { return 0; }
+	virtual BitField<FileAccess::UnixPermissionFlags> _get_unix_permissions(const String &p_file) override { return 0; }
+	virtual Error _set_unix_permissions(const String &p_file, BitField<FileAccess::UnixPermissionFlags> p_permissions) override { return FAILED; }
+
+	virtual bool _get_hidden_attribute(const String &p_file) override { return false; }
+	virtual Error _set_hidden_attribute(const String &p_file, bool p_hidden) override { return ERR_UNAVAILABLE; }
+	virtual bool _get_read_only_attribute(const String &p_file) override { return true; }
+	virtual Error _set_read_only_attribute(const String &p_file, bool p_ro) override { return ERR_UNAVAILABLE; }
+
+	FileAccessMapped() {}
+	~FileAccessMapped();
+};
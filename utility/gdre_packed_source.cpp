@@ -1,7 +1,10 @@
 #include "gdre_packed_source.h"
 #include "core/io/file_access_encrypted.h"
 #include "core/io/file_access_pack.h"
+#include "core/io/marshalls.h"
 #include "core/object/script_language.h"
+#include "core/object/worker_thread_pool.h"
+#include "file_access_encrypted_stream.h"
 #include "file_access_gdre.h"
 #include "gdre_settings.h"
 
@@ -227,9 +230,267 @@ bool GDREPackedSource::_get_exe_embedded_pck_info(Ref<FileAccess> f, const Strin
 	return false;
 }
 
+namespace {
+struct ExePCKInfoCacheEntry {
+	uint64_t size = 0;
+	uint64_t mtime = 0;
+	bool found = false;
+	GDREPackedSource::EXEPCKInfo info;
+};
+Mutex exe_info_cache_mutex;
+HashMap<String, ExePCKInfoCacheEntry> exe_info_cache;
+
+const uint8_t *find_bytes(const uint8_t *p_haystack, uint64_t p_len, const uint8_t *p_needle, uint64_t p_needle_len) {
+#if defined(__GLIBC__) || defined(__APPLE__)
+	return (const uint8_t *)memmem(p_haystack, p_len, p_needle, p_needle_len);
+#else
+	// memchr is vectorized by every libc we build against; only verify where the first byte matches.
+	const uint8_t *end = p_haystack + p_len;
+	const uint8_t *p = p_haystack;
+	while (p_needle_len <= (uint64_t)(end - p)) {
+		p = (const uint8_t *)memchr(p, p_needle[0], end - p - p_needle_len + 1);
+		if (!p) {
+			return nullptr;
+		}
+		if (memcmp(p, p_needle, p_needle_len) == 0) {
+			return p;
+		}
+		p++;
+	}
+	return nullptr;
+#endif
+}
+
+// Sanity-checks a pack header found by scanning, so stray "GDPC" bytes in code or data are not taken for a pack:
+// the versions have to be plausible and the directory has to start with a sane file count and a parseable entry.
+bool is_plausible_pck_header(const uint8_t *p_data, uint64_t p_size, uint64_t p_ofs) {
+	if (p_ofs + 40 > p_size) {
+		return false;
+	}
+	const uint8_t *h = p_data + p_ofs;
+	uint32_t version = decode_uint32(h + 4);
+	uint32_t ver_major = decode_uint32(h + 8);
+	uint32_t ver_minor = decode_uint32(h + 12);
+	if (version > GDREPackedSource::CURRENT_PACK_FORMAT_VERSION || ver_major < 1 || ver_major > 4 || ver_minor > 20) {
+		return false;
+	}
+	uint32_t pack_flags = version >= PACK_FORMAT_VERSION_V2 ? decode_uint32(h + 20) : 0;
+	uint64_t dir_pos;
+	if (version >= PACK_FORMAT_VERSION_V3) {
+		uint64_t dir_offset = decode_uint64(h + 32);
+		if (dir_offset == 0 || dir_offset > p_size - p_ofs) {
+			return false;
+		}
+		dir_pos = p_ofs + dir_offset;
+	} else {
+		// Header fields, 16 reserved words, then the file count.
+		dir_pos = p_ofs + (version == PACK_FORMAT_VERSION_V2 ? 32 : 20) + 16 * 4;
+	}
+	if (dir_pos + 4 > p_size) {
+		return false;
+	}
+	// Path length, at least one path byte, offset, size and MD5.
+	static constexpr uint64_t MIN_ENTRY_SIZE = 4 + 1 + 8 + 8 + 16;
+	uint32_t file_count = decode_uint32(p_data + dir_pos);
+	uint64_t remaining = p_size - dir_pos - 4;
+	if (file_count == 0 || file_count > remaining / MIN_ENTRY_SIZE) {
+		return false;
+	}
+	const uint8_t *entry = p_data + dir_pos + 4;
+	if (pack_flags & PACK_DIR_ENCRYPTED) {
+		// Can't parse the entries; the encryption header (MD5, length, IV) has to fit the count at least.
+		if (remaining < 40) {
+			return false;
+		}
+		uint64_t enc_length = decode_uint64(entry + 16);
+		return enc_length >= file_count * MIN_ENTRY_SIZE && enc_length <= remaining - 40;
+	}
+	uint32_t path_len = decode_uint32(entry);
+	if (path_len == 0 || path_len > 4096 || 4 + (uint64_t)path_len + 32 > remaining) {
+		return false;
+	}
+	for (uint32_t i = 0; i < path_len; i++) {
+		uint8_t c = entry[4 + i];
+		if (c == 0) {
+			// Padding to a multiple of 4, after a non-empty path.
+			if (i == 0) {
+				return false;
+			}
+			break;
+		}
+		if (c < 0x20 || c == 0x7f) {
+			return false;
+		}
+	}
+	uint64_t entry_size = decode_uint64(entry + 4 + path_len + 8);
+	return entry_size <= p_size;
+}
+} //namespace
+
+bool GDREPackedSource::_find_embedded_pck_in_memory(const uint8_t *p_data, uint64_t p_size, bool p_is_pe, EXEPCKInfo &r_info) {
+	auto in_bounds = [&](uint64_t p_ofs, uint64_t p_len) {
+		return p_ofs <= p_size && p_len <= p_size - p_ofs;
+	};
+	bool pck_header_found = false;
+	if (p_is_pe) {
+		if (in_bounds(0x3c, 4)) {
+			uint64_t pe_pos = decode_uint32(p_data + 0x3c);
+			if (in_bounds(pe_pos, 24) && decode_uint32(p_data + pe_pos) == 0x00004550) {
+				r_info.type = EXEPCKInfo::PE;
+				uint64_t header_pos = pe_pos + 4;
+				uint32_t num_sections = decode_uint16(p_data + header_pos + 2);
+				uint64_t section_table_pos = header_pos + 20 + decode_uint16(p_data + header_pos + 16);
+				for (uint32_t i = 0; i < num_sections && in_bounds(section_table_pos + i * 40, 40); i++) {
+					const uint8_t *sh = p_data + section_table_pos + i * 40;
+					if (strncmp((const char *)sh, "pck", 8) == 0) {
+						r_info.pck_section_header_pos = section_table_pos + i * 40;
+						r_info.pck_embed_size = decode_uint32(sh + 16);
+						r_info.pck_embed_off = decode_uint32(sh + 20);
+						pck_header_found = true;
+						break;
+					}
+				}
+			}
+		}
+	} else if (in_bounds(0, 0x40) && decode_uint32(p_data) == 0x464c457f) { // 0x7F + "ELF"
+		r_info.type = EXEPCKInfo::ELF;
+		r_info.section_bit_size = p_data[4] * 32;
+		bool is_32 = r_info.section_bit_size == 32;
+		uint64_t section_table_pos = is_32 ? decode_uint32(p_data + 0x20) : decode_uint64(p_data + 0x28);
+		uint64_t section_header_size = is_32 ? 40 : 64;
+		uint32_t num_sections = decode_uint16(p_data + (is_32 ? 0x30 : 0x3c));
+		uint32_t string_section_idx = decode_uint16(p_data + (is_32 ? 0x32 : 0x3e));
+		auto read_section = [&](uint64_t p_header_pos, uint64_t &r_off, uint64_t &r_size) {
+			if (is_32) {
+				r_off = decode_uint32(p_data + p_header_pos + 0x10);
+				r_size = decode_uint32(p_data + p_header_pos + 0x14);
+			} else {
+				r_off = decode_uint64(p_data + p_header_pos + 0x18);
+				r_size = decode_uint64(p_data + p_header_pos + 0x20);
+			}
+		};
+		uint64_t strings_header_pos = section_table_pos + string_section_idx * section_header_size;
+		if (in_bounds(strings_header_pos, section_header_size)) {
+			uint64_t strings_pos = 0;
+			uint64_t strings_size = 0;
+			read_section(strings_header_pos, strings_pos, strings_size);
+			for (uint32_t i = 0; i < num_sections && in_bounds(strings_pos, strings_size); i++) {
+				uint64_t section_header_pos = section_table_pos + i * section_header_size;
+				if (!in_bounds(section_header_pos, section_header_size)) {
+					break;
+				}
+				uint64_t name_offset = decode_uint32(p_data + section_header_pos);
+				if (name_offset + 4 <= strings_size && memcmp(p_data + strings_pos + name_offset, "pck", 4) == 0) {
+					r_info.pck_section_header_pos = section_header_pos;
+					read_section(section_header_pos, r_info.pck_embed_off, r_info.pck_embed_size);
+					pck_header_found = true;
+					break;
+				}
+			}
+		}
+	}
+
+	if (pck_header_found && r_info.pck_embed_off != 0) {
+		// Search for the header, in case PCK start and section have different alignment.
+		for (uint64_t i = 0; i < 8 && in_bounds(r_info.pck_embed_off + i, 4); i++) {
+			if (decode_uint32(p_data + r_info.pck_embed_off + i) != PACK_HEADER_MAGIC) {
+				continue;
+			}
+			r_info.pck_actual_off = r_info.pck_embed_off + i;
+			uint64_t embed_end = r_info.pck_embed_off + r_info.pck_embed_size;
+			if (embed_end >= 12 && in_bounds(embed_end - 12, 12) && decode_uint32(p_data + embed_end - 4) == PACK_HEADER_MAGIC) {
+				r_info.pck_actual_size = decode_uint64(p_data + embed_end - 12);
+			} else {
+				WARN_PRINT("PCK header not found at the end of the embed section.");
+				r_info.pck_actual_size = r_info.pck_embed_size - i;
+			}
+			return true;
+		}
+	}
+
+	// Search for the header at the end of file - self contained executable.
+	if (p_size >= 16 && decode_uint32(p_data + p_size - 4) == PACK_HEADER_MAGIC) {
+		uint64_t pck_size = decode_uint64(p_data + p_size - 12);
+		if (pck_size + 12 <= p_size) {
+			uint64_t embed_off = p_size - 12 - pck_size;
+			if (in_bounds(embed_off, 4) && decode_uint32(p_data + embed_off) == PACK_HEADER_MAGIC) {
+				r_info.pck_section_header_pos = 0;
+				r_info.pck_actual_size = pck_size;
+				r_info.pck_embed_size = pck_size + 12; // pck_size + magic at the end
+				r_info.pck_embed_off = embed_off;
+				r_info.pck_actual_off = embed_off;
+				return true;
+			}
+		}
+	}
+
+	// Section info stripped or wrong and no trailer: look for the pack header itself.
+	uint8_t magic[4];
+	encode_uint32(PACK_HEADER_MAGIC, magic);
+	uint64_t search_pos = 0;
+	while (search_pos < p_size) {
+		const uint8_t *found = find_bytes(p_data + search_pos, p_size - search_pos, magic, 4);
+		if (!found) {
+			break;
+		}
+		uint64_t ofs = found - p_data;
+		if (is_plausible_pck_header(p_data, p_size, ofs)) {
+			WARN_PRINT("PCK section info missing or invalid, found PCK header at offset 0x" + String::num_int64(ofs, 16));
+			r_info.pck_section_header_pos = 0;
+			r_info.pck_embed_off = ofs;
+			r_info.pck_actual_off = ofs;
+			r_info.pck_embed_size = p_size - ofs;
+			r_info.pck_actual_size = p_size - ofs;
+			return true;
+		}
+		search_pos = ofs + 1;
+	}
+
+	r_info.pck_actual_off = 0;
+	r_info.pck_actual_size = 0;
+	return false;
+}
+
+bool GDREPackedSource::_get_exe_embedded_pck_info_cached(const String &p_path, EXEPCKInfo &r_info) {
+	Ref<FileAccess> f = FileAccess::open(p_path, FileAccess::READ);
+	if (f.is_null()) {
+		return false;
+	}
+	uint64_t size = f->get_length();
+	uint64_t mtime = FileAccess::get_modified_time(p_path);
+	{
+		MutexLock lock(exe_info_cache_mutex);
+		const ExePCKInfoCacheEntry *cached = exe_info_cache.getptr(p_path);
+		if (cached && cached->size == size && cached->mtime == mtime) {
+			r_info = cached->info;
+			return cached->found;
+		}
+	}
+	bool is_pe = p_path.get_extension().to_lower() == "exe";
+	bool found = false;
+	Ref<PackMapping> mapping = PackMapping::map_file(p_path);
+	if (mapping.is_valid()) {
+		mapping->advise(0, mapping->get_size(), PackMapping::ACCESS_SEQUENTIAL);
+		found = _find_embedded_pck_in_memory(mapping->get_data(), mapping->get_size(), is_pe, r_info);
+	} else {
+		found = _get_exe_embedded_pck_info(f, p_path, r_info);
+	}
+	MutexLock lock(exe_info_cache_mutex);
+	ExePCKInfoCacheEntry &entry = exe_info_cache[p_path];
+	entry.size = size;
+	entry.mtime = mtime;
+	entry.found = found;
+	entry.info = r_info;
+	return found;
+}
+
 bool GDREPackedSource::seek_offset_from_exe(Ref<FileAccess> f, const String &p_path) {
 	EXEPCKInfo info;
-	auto ret = _get_exe_embedded_pck_info(f, p_path, info);
+	auto ret = _get_exe_embedded_pck_info_cached(p_path, info);
+	if (ret) {
+		// Leave the file just past the header magic, as the callers expect.
+		f->seek(info.pck_actual_off + 4);
+	}
 #ifdef DEBUG_ENABLED
 	if (ret) {
 		if (info.pck_section_header_pos == 0) {
@@ -249,8 +510,7 @@ bool GDREPackedSource::seek_offset_from_exe(Ref<FileAccess> f, const String &p_p
 }
 
 bool GDREPackedSource::get_exe_embedded_pck_info(const String &p_path, GDREPackedSource::EXEPCKInfo &r_info) {
-	Ref<FileAccess> f = FileAccess::open(p_path, FileAccess::READ);
-	auto ret = _get_exe_embedded_pck_info(f, p_path, r_info);
+	auto ret = _get_exe_embedded_pck_info_cached(p_path, r_info);
 #ifdef DEBUG_ENABLED
 	if (ret) {
 		print_verbose("PCK embed offset: " + String::num_int64(r_info.pck_embed_off, 16));
@@ -272,24 +532,21 @@ bool GDREPackedSource::has_embedded_pck(const String &p_path) {
 	if (!is_executable(p_path)) {
 		return false;
 	}
-	Ref<FileAccess> f = FileAccess::open(p_path, FileAccess::READ);
-	if (f.is_null()) {
-		return false;
-	}
-	return seek_offset_from_exe(f, p_path);
+	EXEPCKInfo info;
+	return _get_exe_embedded_pck_info_cached(p_path, info);
 }
 
-bool GDREPackedSource::try_open_pack(const String &p_path, bool p_replace_files, uint64_t p_offset) {
+bool GDREPackedSource::_parse_pack(const String &p_path, uint64_t p_offset, ParsedPack &r_pack) {
 	if (p_path.get_extension().to_lower() == "apk" || p_path.get_extension().to_lower() == "zip") {
 		return false;
 	}
 	String pck_path = p_path.replace("_GDRE_a_really_dumb_hack", "");
+	r_pack.pck_path = pck_path;
 	Ref<FileAccess> f = FileAccess::open(pck_path, FileAccess::READ);
 	ERR_FAIL_COND_V_MSG(f.is_null(), false, "Failed to open pack file: " + pck_path);
 
 	f->seek(p_offset);
 
-	bool is_exe = false;
 	uint32_t magic = f->get_32();
 
 	if (magic != PACK_HEADER_MAGIC) {
@@ -301,7 +558,7 @@ bool GDREPackedSource::try_open_pack(const String &p_path, bool p_replace_files,
 		if (!seek_offset_from_exe(f, pck_path)) {
 			return false;
 		}
-		is_exe = true;
+		r_pack.is_exe = true;
 	}
 
 	int64_t pck_start_pos = f->get_position() - 4;
@@ -356,7 +613,7 @@ bool GDREPackedSource::try_open_pack(const String &p_path, bool p_replace_files,
 	if (enc_directory) {
 		Ref<FileAccessEncrypted> fae = memnew(FileAccessEncrypted);
 		if (fae.is_null()) {
-			GDRESettings::get_singleton()->_set_error_encryption(true);
+			r_pack.encryption_error = true;
 			ERR_FAIL_V_MSG(false, "Failed to instance FileAccessEncrypted??????.");
 		}
 
@@ -368,29 +625,71 @@ bool GDREPackedSource::try_open_pack(const String &p_path, bool p_replace_files,
 
 		Error err = fae->open_and_parse(f, key, FileAccessEncrypted::MODE_READ, false);
 		if (err) {
-			GDRESettings::get_singleton()->_set_error_encryption(true);
+			r_pack.encryption_error = true;
 			ERR_FAIL_V_MSG(false, "Can't open encrypted pack directory (PCK format version " + itos(version) + ", engine version " + itos(ver_major) + "." + itos(ver_minor) + "." + itos(ver_patch) + ").");
 		}
 		f = fae;
 	}
 
-	// Set Pack info before reading the file list.
+	r_pack.version = version;
+	r_pack.ver_major = ver_major;
+	r_pack.ver_minor = ver_minor;
+	r_pack.ver_patch = ver_patch;
+	r_pack.pack_flags = pack_flags;
+	r_pack.file_base = file_base;
+	r_pack.file_count = file_count;
+	r_pack.enc_directory = enc_directory;
+
+	// Read the file list.
+	r_pack.entries.resize(file_count);
+	for (uint32_t i = 0; i < file_count; i++) {
+		ParsedPackEntry &entry = r_pack.entries[i];
+		uint32_t sl = f->get_32();
+		CharString cs;
+		cs.resize_uninitialized(sl + 1);
+		f->get_buffer((uint8_t *)cs.ptr(), sl);
+		cs[sl] = 0;
+
+		entry.path.append_utf8(cs.ptr());
+		String p_file = entry.path.get_file();
+		ERR_FAIL_COND_V_MSG(p_file.begins_with("gdre_") && p_file != "gdtr_export.log", false, "Don't try to extract the GDRE pack files, just download the source from github.");
+
+		// TODO: Ask bruvzg about whether or not p_offset is needed here.
+		entry.ofs = file_base + f->get_64() + (version >= PACK_FORMAT_VERSION_V3 ? 0 : p_offset);
+		entry.size = f->get_64();
+		f->get_buffer(entry.md5, 16);
+		if (version >= PACK_FORMAT_VERSION_V2) {
+			entry.flags = f->get_32();
+		}
+	}
+	r_pack.valid = true;
+	return true;
+}
+
+bool GDREPackedSource::_commit_pack(const ParsedPack &p_pack, bool p_replace_files) {
+	if (!p_pack.valid) {
+		if (p_pack.encryption_error) {
+			GDRESettings::get_singleton()->_set_error_encryption(true);
+		}
+		return false;
+	}
+	// Set Pack info before adding the files.
 	String ver_string;
 
 	Ref<GodotVer> godot_ver;
 	bool suspect_version = false;
-	if (ver_major < 2) {
+	if (p_pack.ver_major < 2) {
 		// it is very unlikely that we will encounter Godot 1.x games in the wild.
 		// This is likely a pck created with a creation tool.
 		// We need to determine the version number from the binary resources.
 		// (if it is 1.x, we'll determine that through the binary resources too)
 		suspect_version = true;
 	}
-	if (ver_major < 3 || (ver_major == 3 && ver_minor < 2)) {
+	if (p_pack.ver_major < 3 || (p_pack.ver_major == 3 && p_pack.ver_minor < 2)) {
 		// they only started writing the actual patch number in 3.2
-		ver_string = itos(ver_major) + "." + itos(ver_minor);
+		ver_string = itos(p_pack.ver_major) + "." + itos(p_pack.ver_minor);
 	} else {
-		ver_string = itos(ver_major) + "." + itos(ver_minor) + "." + itos(ver_patch);
+		ver_string = itos(p_pack.ver_major) + "." + itos(p_pack.ver_minor) + "." + itos(p_pack.ver_patch);
 	}
 	godot_ver = GodotVer::parse(ver_string);
 
@@ -398,40 +697,155 @@ bool GDREPackedSource::try_open_pack(const String &p_path, bool p_replace_files,
 	Ref<GDRESettings::PackInfo> pckinfo;
 	pckinfo.instantiate();
 	pckinfo->init(
-			pck_path, godot_ver, version, pack_flags, file_base, file_count, is_exe ? GDRESettings::PackInfo::EXE : GDRESettings::PackInfo::PCK, enc_directory, suspect_version);
+			p_pack.pck_path, godot_ver, p_pack.version, p_pack.pack_flags, p_pack.file_base, p_pack.file_count, p_pack.is_exe ? GDRESettings::PackInfo::EXE : GDRESettings::PackInfo::PCK, p_pack.enc_directory, suspect_version);
 	GDRESettings::get_singleton()->add_pack_info(pckinfo);
 
-	// Read the file list.
-	for (uint32_t i = 0; i < file_count; i++) {
-		uint32_t sl = f->get_32();
-		CharString cs;
-		cs.resize_uninitialized(sl + 1);
-		f->get_buffer((uint8_t *)cs.ptr(), sl);
-		cs[sl] = 0;
+	for (const ParsedPackEntry &entry : p_pack.entries) {
+		if (entry.flags & PACK_FILE_REMOVAL) { // The file was removed.
+			GDREPackedData::get_singleton()->remove_path(entry.path);
+		} else {
+			GDREPackedData::get_singleton()->add_path(p_pack.pck_path, entry.path, entry.ofs, entry.size, entry.md5, this, p_replace_files, (entry.flags & PACK_FILE_ENCRYPTED), true);
+		}
+	}
 
-		String path;
-		path.append_utf8(cs.ptr());
-		String p_file = path.get_file();
-		ERR_FAIL_COND_V_MSG(p_file.begins_with("gdre_") && p_file != "gdtr_export.log", false, "Don't try to extract the GDRE pack files, just download the source from github.");
+	return true;
+}
 
-		// TODO: Ask bruvzg about whether or not p_offset is needed here.
-		uint64_t ofs = file_base + f->get_64() + (version >= PACK_FORMAT_VERSION_V3 ? 0 : p_offset);
-		uint64_t size = f->get_64();
-		uint8_t md5[16];
-		uint32_t flags = 0;
-		f->get_buffer(md5, 16);
-		if (version >= PACK_FORMAT_VERSION_V2) {
-			flags = f->get_32();
+void GDREPackedSource::_prefetch_task(uint32_t p_idx, ParsedPack *p_packs) {
+	_parse_pack(p_packs[p_idx].pck_path, 0, p_packs[p_idx]);
+}
+
+void GDREPackedSource::prefetch_directories(const Vector<String> &p_paths) {
+	{
+		MutexLock lock(prefetch_mutex);
+		prefetched.clear();
+	}
+	if (p_paths.size() < 2) {
+		return;
+	}
+	LocalVector<ParsedPack> packs;
+	packs.resize(p_paths.size());
+	for (int i = 0; i < p_paths.size(); i++) {
+		packs[i].pck_path = p_paths[i];
+	}
+	WorkerThreadPool::GroupID group_id = WorkerThreadPool::get_singleton()->add_template_group_task(
+			this, &GDREPackedSource::_prefetch_task, packs.ptr(), packs.size(), -1, true, "GDREPackedSource::prefetch_directories");
+	WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group_id);
+
+	MutexLock lock(prefetch_mutex);
+	for (int i = 0; i < p_paths.size(); i++) {
+		prefetched[p_paths[i]] = std::move(packs[i]);
+	}
+}
+
+bool GDREPackedSource::try_open_pack(const String &p_path, bool p_replace_files, uint64_t p_offset) {
+	if (p_offset == 0) {
+		ParsedPack pack;
+		bool found = false;
+		{
+			MutexLock lock(prefetch_mutex);
+			auto E = prefetched.find(p_path);
+			if (E) {
+				pack = std::move(E->value);
+				prefetched.remove(p_path);
+				found = true;
+			}
 		}
-		if (flags & PACK_FILE_REMOVAL) { // The file was removed.
-			GDREPackedData::get_singleton()->remove_path(path);
-		} else {
-			GDREPackedData::get_singleton()->add_path(pck_path, path, ofs, size, md5, this, p_replace_files, (flags & PACK_FILE_ENCRYPTED), true);
+		if (found) {
+			return _commit_pack(pack, p_replace_files);
 		}
 	}
+	ParsedPack pack;
+	_parse_pack(p_path, p_offset, pack);
+	return _commit_pack(pack, p_replace_files);
+}
 
-	return true;
+Ref<PackMapping> GDREPackedSource::_get_mapping(const String &p_pack_path) {
+	MutexLock lock(mapping_mutex);
+	auto E = mappings.find(p_pack_path);
+	if (E) {
+		return E->value;
+	}
+	if (unmappable.has(p_pack_path)) {
+		return Ref<PackMapping>();
+	}
+	Ref<PackMapping> mapping = PackMapping::map_file(p_pack_path);
+	if (mapping.is_null()) {
+		unmappable.insert(p_pack_path);
+		return mapping;
+	}
+	mappings[p_pack_path] = mapping;
+	return mapping;
 }
+
+void GDREPackedSource::release_mapping(const String &p_pack_path) {
+	MutexLock lock(mapping_mutex);
+	String simplified = p_pack_path.simplify_path();
+	LocalVector<String> to_remove;
+	for (const KeyValue<String, Ref<PackMapping>> &E : mappings) {
+		if (E.key.simplify_path() == simplified) {
+			to_remove.push_back(E.key);
+		}
+	}
+	for (const String &key : to_remove) {
+		mappings.erase(key);
+		unmappable.insert(key);
+	}
+	unmappable.insert(p_pack_path);
+}
+
 Ref<FileAccess> GDREPackedSource::get_file(const String &p_path, PackedData::PackedFile *p_file) {
+	return _open_file(p_path, p_file, false);
+}
+
+Ref<FileAccess> GDREPackedSource::get_file_sequential(const String &p_path, PackedData::PackedFile *p_file) {
+	return _open_file(p_path, p_file, true);
+}
+
+Ref<FileAccess> GDREPackedSource::_open_file(const String &p_path, PackedData::PackedFile *p_file, bool p_sequential) {
+	// Unencrypted entries are served straight out of a shared mapping of the pack.
+	if (!p_file->encrypted && PackMapping::is_supported()) {
+		Ref<PackMapping> mapping = _get_mapping(p_file->pack);
+		if (mapping.is_valid() && mapping->has_range(p_file->offset, p_file->size)) {
+			Ref<FileAccessMapped> fa;
+			fa.instantiate();
+			if (fa->open_range(mapping, p_file->offset, p_file->size, p_sequential) == OK) {
+				return fa;
+			}
+		}
+	}
+	// Large encrypted entries are decrypted chunk by chunk rather than all at once on open. Unless the caller reads
+	// front to back and checks get_error() at the end, the MD5 is verified on open.
+	if (p_file->encrypted && p_file->size >= STREAM_DECRYPT_MIN_SIZE) {
+		Ref<FileAccess> f = FileAccess::open(p_file->pack, FileAccess::READ);
+		if (f.is_valid()) {
+			f->seek(p_file->offset);
+			Vector<uint8_t> key;
+			key.resize(32);
+			for (int i = 0; i < key.size(); i++) {
+				key.write[i] = script_encryption_key[i];
+			}
+			Ref<FileAccessEncryptedStream> fae;
+			fae.instantiate();
+			Error err = fae->open_and_parse(f, key, !p_sequential);
+			if (err == OK) {
+				return fae;
+			}
+			// A checksum failure means a wrong key or corrupt data; FileAccessPack would fail the same way.
+			ERR_FAIL_COND_V_MSG(err == ERR_FILE_CORRUPT, Ref<FileAccess>(), "Failed to decrypt " + p_path + ": the checksum doesn't match (invalid key?)");
+		}
+	}
 	return memnew(FileAccessPack(p_path, *p_file));
 }
+
+void GDREPackedSource::prefetch_range(const String &p_pack_path, uint64_t p_offset, uint64_t p_length) {
+	if (!PackMapping::is_supported()) {
+		return;
+	}
+	Ref<PackMapping> mapping = _get_mapping(p_pack_path);
+	if (mapping.is_valid()) {
+		// Only the start of large entries; the rest is read ahead as the entry is consumed (on faults, or over the
+		// whole entry once it is opened with get_file_sequential).
+		mapping->advise(p_offset, MIN(p_length, PREFETCH_MAX_LENGTH), PackMapping::ACCESS_WILLNEED);
+	}
+}
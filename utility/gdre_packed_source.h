@@ -1,6 +1,9 @@
 #pragma once
 
 #include "core/io/file_access_pack.h"
+#include "core/os/mutex.h"
+#include "core/templates/local_vector.h"
+#include "utility/file_access_mapped.h"
 
 class GDREPackedSource : public PackSource {
 public:
@@ -21,7 +24,56 @@ public:
 	};
 
 private:
+	struct ParsedPackEntry {
+		String path;
+		uint64_t ofs = 0;
+		uint64_t size = 0;
+		uint8_t md5[16] = {};
+		uint32_t flags = 0;
+	};
+
+	// A pack header and directory, read without touching any global state so packs can be parsed concurrently.
+	struct ParsedPack {
+		String pck_path;
+		bool valid = false;
+		bool encryption_error = false;
+		bool is_exe = false;
+		bool enc_directory = false;
+		uint32_t version = 0;
+		uint32_t ver_major = 0;
+		uint32_t ver_minor = 0;
+		uint32_t ver_patch = 0;
+		uint32_t pack_flags = 0;
+		uint64_t file_base = 0;
+		uint32_t file_count = 0;
+		LocalVector<ParsedPackEntry> entries;
+	};
+
+	// Directories parsed ahead of time by prefetch_directories, consumed by try_open_pack.
+	Mutex prefetch_mutex;
+	HashMap<String, ParsedPack> prefetched;
+
+	bool _parse_pack(const String &p_path, uint64_t p_offset, ParsedPack &r_pack);
+	// Registers the pack info and adds (or removes) its paths, in directory order.
+	bool _commit_pack(const ParsedPack &p_pack, bool p_replace_files);
+	void _prefetch_task(uint32_t p_idx, ParsedPack *p_packs);
+
+	static constexpr uint64_t PREFETCH_MAX_LENGTH = 4 * 1024 * 1024;
+	// Smaller encrypted entries still go through FileAccessPack, which verifies the MD5 on open.
+	static constexpr uint64_t STREAM_DECRYPT_MIN_SIZE = 16 * 1024 * 1024;
+
+	Mutex mapping_mutex;
+	HashMap<String, Ref<PackMapping>> mappings;
+	HashSet<String> unmappable;
+
+	Ref<PackMapping> _get_mapping(const String &p_pack_path);
+	Ref<FileAccess> _open_file(const String &p_path, PackedData::PackedFile *p_file, bool p_sequential);
+
 	static bool _get_exe_embedded_pck_info(Ref<FileAccess> f, const String &p_path, GDREPackedSource::EXEPCKInfo &r_info);
+	// Same detection as above, but parsing a mapped image and falling back to scanning for the pack magic.
+	static bool _find_embedded_pck_in_memory(const uint8_t *p_data, uint64_t p_size, bool p_is_pe, GDREPackedSource::EXEPCKInfo &r_info);
+	// Results are cached by path, size and modification time.
+	static bool _get_exe_embedded_pck_info_cached(const String &p_path, GDREPackedSource::EXEPCKInfo &r_info);
 	static bool seek_after_magic_unix(Ref<FileAccess> f);
 	static bool get_pck_section_info_unix(Ref<FileAccess> f, GDREPackedSource::EXEPCKInfo &info);
 	static bool seek_after_magic_windows(Ref<FileAccess> f);
@@ -34,6 +86,17 @@ public:
 	static bool is_embeddable_executable(const String &p_path);
 	static bool has_embedded_pck(const String &p_path);
 	static bool get_exe_embedded_pck_info(const String &p_path, GDREPackedSource::EXEPCKInfo &r_info);
+	// Reads and decodes the directories of several packs in parallel. The packs are still added in the
+	// order try_open_pack is called for them, so override order is unchanged.
+	void prefetch_directories(const Vector<String> &p_paths);
 	virtual bool try_open_pack(const String &p_path, bool p_replace_files, uint64_t p_offset);
 	virtual Ref<FileAccess> get_file(const String &p_path, PackedData::PackedFile *p_file);
+	// For consumers that read the entry once, front to back, and check get_error() afterwards: large encrypted
+	// entries skip the up-front checksum pass and report a mismatch through get_error() once fully read.
+	Ref<FileAccess> get_file_sequential(const String &p_path, PackedData::PackedFile *p_file);
+	// Stops serving entries of p_pack_path from a mapping, so the file can be opened for writing (Windows won't
+	// allow that while it is mapped). Views already handed out keep the old mapping until they are closed.
+	void release_mapping(const String &p_pack_path);
+	// Asks the OS to start reading a range of a pack that is about to be read.
+	void prefetch_range(const String &p_pack_path, uint64_t p_offset, uint64_t p_length);
 };
@@ -553,10 +553,13 @@ Error GDRESettings::load_project(const Vector<String> &p_paths, bool _cmd_line_e
 		load_pack_uid_cache();
 		load_pack_gdscript_cache();
 	} else {
+		// Resolve every pack first so their directories can be read in parallel; they are still loaded in order.
+		Vector<String> load_paths;
 		for (auto path : pck_files) {
 			auto san_path = sanitize_home_in_path(path);
 			print_line("Opening file: " + san_path);
 			if (check_embedded(path) != OK) {
+				err = ERR_CANT_OPEN;
 				String new_path = path;
 				String parent_path = path.get_base_dir();
 				if (parent_path.is_empty()) {
@@ -592,6 +595,10 @@ Error GDRESettings::load_project(const Vector<String> &p_paths, bool _cmd_line_e
 				path = new_path;
 				WARN_PRINT("Could not find embedded pck in EXE, found pck file, loading from: " + san_path);
 			}
+			load_paths.push_back(path);
+		}
+		GDREPackedData::get_singleton()->prefetch_packs(load_paths);
+		for (const String &path : load_paths) {
 			err = load_pck(path);
 			if (err) {
 				unload_project();
@@ -918,6 +925,7 @@ Error GDRESettings::unload_project() {
 	error_encryption = false;
 	reset_uid_cache();
 	reset_gdscript_cache();
+	reset_decrypted_script_cache();
 	if (get_pack_type() == PackInfo::DIR) {
 		unload_dir();
 	}
@@ -1024,6 +1032,7 @@ Error GDRESettings::set_encryption_key(Vector<uint8_t> key) {
 	set_key = true;
 	enc_key = key;
 	enc_key_str = String::hex_encode_buffer(key.ptr(), 32);
+	reset_decrypted_script_cache();
 	return OK;
 }
 
@@ -1708,6 +1717,64 @@ Error GDRESettings::reset_gdscript_cache() {
 	return OK;
 }
 
+String GDRESettings::_get_decrypted_script_cache_key(const String &p_path, int p_ver_major, const Vector<uint8_t> &p_key) {
+	// Only cache scripts from the loaded project decrypted with the project key; anything else is a probe.
+	if (!is_pack_loaded() || p_key != enc_key) {
+		return "";
+	}
+	int64_t offset = GDREPackedData::get_singleton()->get_file_offset(p_path);
+	if (offset < 0) {
+		return "";
+	}
+	return p_path.simplify_path() + "@" + itos(offset) + ":" + itos(p_ver_major);
+}
+
+bool GDRESettings::get_cached_decrypted_script(const String &p_path, int p_ver_major, const Vector<uint8_t> &p_key, Vector<uint8_t> &r_buffer) {
+	String key = _get_decrypted_script_cache_key(p_path, p_ver_major, p_key);
+	if (key.is_empty()) {
+		return false;
+	}
+	MutexLock lock(decrypted_script_mutex);
+	auto E = decrypted_script_cache.find(key);
+	if (!E) {
+		return false;
+	}
+	r_buffer = E->value;
+	return true;
+}
+
+void GDRESettings::cache_decrypted_script(const String &p_path, int p_ver_major, const Vector<uint8_t> &p_key, const Vector<uint8_t> &p_buffer) {
+	if (p_buffer.size() > MAX_DECRYPTED_SCRIPT_CACHE_SIZE) {
+		return;
+	}
+	String key = _get_decrypted_script_cache_key(p_path, p_ver_major, p_key);
+	if (key.is_empty()) {
+		return;
+	}
+	MutexLock lock(decrypted_script_mutex);
+	if (decrypted_script_cache.has(key)) {
+		return;
+	}
+	while (!decrypted_script_order.is_empty() && decrypted_script_cache_size + p_buffer.size() > MAX_DECRYPTED_SCRIPT_CACHE_SIZE) {
+		auto E = decrypted_script_cache.find(decrypted_script_order.front()->get());
+		if (E) {
+			decrypted_script_cache_size -= E->value.size();
+			decrypted_script_cache.remove(E);
+		}
+		decrypted_script_order.pop_front();
+	}
+	decrypted_script_cache[key] = p_buffer;
+	decrypted_script_order.push_back(key);
+	decrypted_script_cache_size += p_buffer.size();
+}
+
+void GDRESettings::reset_decrypted_script_cache() {
+	MutexLock lock(decrypted_script_mutex);
+	decrypted_script_cache.clear();
+	decrypted_script_order.clear();
+	decrypted_script_cache_size = 0;
+}
+
 void GDRESettings::_do_import_load(uint32_t i, IInfoToken *tokens) {
 	tokens[i].info = ImportInfo::load_from_file(tokens[i].path, tokens[i].ver_major, tokens[i].ver_minor);
 	if (tokens[i].info.is_null()) {
@@ -1725,6 +1792,12 @@ String GDRESettings::get_IInfoToken_description(uint32_t i, IInfoToken *p_userda
 	return p_userdata[i].path;
 }
 
+static TaskManager::IOLocalityKey get_path_locality(const String &p_path) {
+	TaskManager::IOLocalityKey key;
+	GDREPackedData::get_singleton()->get_io_locality(p_path, key.pack, key.offset);
+	return key;
+}
+
 Error GDRESettings::load_import_files() {
 	Vector<String> resource_files;
 	ERR_FAIL_COND_V_MSG(!is_pack_loaded(), ERR_DOES_NOT_EXIST, "pack/dir not loaded!");
@@ -1765,6 +1838,7 @@ Error GDRESettings::load_import_files() {
 		print_line("No import files found!");
 		return OK;
 	}
+	TaskManager::sort_by_io_locality(tokens, [](const IInfoToken &p_token) { return get_path_locality(p_token.path); });
 
 	Error err = TaskManager::get_singleton()->run_multithreaded_group_task(
 			this,
@@ -1781,14 +1855,14 @@ Error GDRESettings::load_import_files() {
 	}
 	for (int i = 0; i < tokens.size(); i++) {
 		if (tokens[i].info.is_null()) {
-			WARN_PRINT("Can't load import file: " + resource_files[i]);
+			WARN_PRINT("Can't load import file: " + tokens[i].path);
 			continue;
 		}
 		if (tokens[i].info->get_iitype() == ImportInfo::REMAP) {
 			if (tokens[i].err == ERR_FILE_MISSING_DEPENDENCIES) {
 				WARN_PRINT(vformat("Remapped path does not exist: %s -> %s", tokens[i].info->get_source_file(), tokens[i].info->get_path()));
 			} else if (tokens[i].err) {
-				WARN_PRINT("Can't load remap file: " + resource_files[i] + " (" + itos(tokens[i].err) + ")");
+				WARN_PRINT("Can't load remap file: " + tokens[i].path + " (" + itos(tokens[i].err) + ")");
 				continue;
 			} else {
 				remap_iinfo.insert(tokens[i].path, tokens[i].info);
@@ -2008,6 +2082,7 @@ void GDRESettings::load_all_resource_strings() {
 		current_project->string_load_tokens.write[i].path = r_files[i];
 		current_project->string_load_tokens.write[i].engine_version = engine_ver;
 	}
+	TaskManager::sort_by_io_locality(current_project->string_load_tokens, [](const StringLoadToken &p_token) { return get_path_locality(p_token.path); });
 	print_line("Loading resource strings, this may take a while!!");
 	Error err = TaskManager::get_singleton()->run_multithreaded_group_task(
 			this,
@@ -166,6 +166,13 @@ private:
 	ParallelFlatHashMap<String, ResourceUID::ID> path_to_uid;
 	HashMap<String, Dictionary> script_cache;
 
+	// Decrypted .gde buffers, keyed by path and pack offset; bounded by total size and evicted oldest-first.
+	static constexpr int64_t MAX_DECRYPTED_SCRIPT_CACHE_SIZE = 64 * 1024 * 1024;
+	Mutex decrypted_script_mutex;
+	HashMap<String, Vector<uint8_t>> decrypted_script_cache;
+	List<String> decrypted_script_order;
+	int64_t decrypted_script_cache_size = 0;
+
 	uint8_t old_key[32] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
 	bool set_key = false;
 	Vector<uint8_t> enc_key;
@@ -201,6 +208,7 @@ private:
 
 	Error load_pack_gdscript_cache(bool p_reset = false);
 	Error reset_gdscript_cache();
+	String _get_decrypted_script_cache_key(const String &p_path, int p_ver_major, const Vector<uint8_t> &p_key);
 
 	Error detect_bytecode_revision(bool p_no_valid_version);
 
@@ -233,6 +241,10 @@ public:
 	void reset_encryption_key();
 	void add_pack_info(Ref<PackInfo> packinfo);
 
+	bool get_cached_decrypted_script(const String &p_path, int p_ver_major, const Vector<uint8_t> &p_key, Vector<uint8_t> &r_buffer);
+	void cache_decrypted_script(const String &p_path, int p_ver_major, const Vector<uint8_t> &p_key, const Vector<uint8_t> &p_buffer);
+	void reset_decrypted_script_cache();
+
 	StringName get_cached_script_class(const String &p_path);
 	StringName get_cached_script_base(const String &p_path);
 
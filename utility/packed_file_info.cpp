@@ -16,7 +16,11 @@ void PackedFileInfo::_bind_methods() {
 #define PATH_REPLACER "_"
 
 void PackedFileInfo::fix_path() {
-	path = raw_path;
+	path = get_fixed_path(raw_path, malformed_path);
+}
+
+String PackedFileInfo::get_fixed_path(const String &p_raw_path, bool &malformed_path) {
+	String path = p_raw_path;
 	malformed_path = false;
 	String prefix = "";
 
@@ -93,4 +97,5 @@ void PackedFileInfo::fix_path() {
 	if (prefix != "") {
 		path = prefix + path;
 	}
+	return path;
 }
\ No newline at end of file
@@ -67,6 +67,9 @@ public:
 		return md5_passed;
 	}
 
+	// Sanitizes a path read from a pack; r_malformed is set if anything had to be changed.
+	static String get_fixed_path(const String &p_raw_path, bool &r_malformed);
+
 protected:
 	static void _bind_methods();
 
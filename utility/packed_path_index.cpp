@@ -0,0 +1,412 @@
+#include "packed_path_index.h"
+
+#include "core/templates/sort_array.h"
+
+namespace {
+struct EntryPathLess {
+	const char32_t *arena = nullptr;
+	const PackedPathIndex::Entry *entries = nullptr;
+
+	_FORCE_INLINE_ bool operator()(uint32_t p_a, uint32_t p_b) const {
+		const PackedPathIndex::Entry &a = entries[p_a];
+		const PackedPathIndex::Entry &b = entries[p_b];
+		const char32_t *pa = arena + a.path_ofs;
+		const char32_t *pb = arena + b.path_ofs;
+		uint32_t len = MIN(a.path_len, b.path_len);
+		for (uint32_t i = 0; i < len; i++) {
+			if (pa[i] != pb[i]) {
+				return pa[i] < pb[i];
+			}
+		}
+		return a.path_len < b.path_len;
+	}
+};
+
+// <0 if the path sorts before every path starting with p_prefix, 0 if it starts with it, >0 if after.
+int compare_prefix(const char32_t *p_path, uint32_t p_path_len, const char32_t *p_prefix, uint32_t p_prefix_len) {
+	uint32_t len = MIN(p_path_len, p_prefix_len);
+	for (uint32_t i = 0; i < len; i++) {
+		if (p_path[i] != p_prefix[i]) {
+			return p_path[i] < p_prefix[i] ? -1 : 1;
+		}
+	}
+	return p_path_len < p_prefix_len ? -1 : 0;
+}
+} //namespace
+
+uint64_t PackedPathIndex::_hash(const char32_t *p_str, uint32_t p_len) {
+	uint64_t h = 0xcbf29ce484222325ULL;
+	for (uint32_t i = 0; i < p_len; i++) {
+		h ^= (uint64_t)p_str[i];
+		h *= 0x100000001b3ULL;
+	}
+	return h;
+}
+
+bool PackedPathIndex::_is_canonical(const char32_t *p_str, uint32_t p_len) {
+	// Anything simplify_path() would change: backslashes, drive prefixes, and empty, "." or ".." segments.
+	uint32_t seg_start = 0;
+	for (uint32_t i = 0; i <= p_len; i++) {
+		if (i < p_len && p_str[i] != '/') {
+			if (p_str[i] == '\\' || p_str[i] == ':') {
+				return false;
+			}
+			continue;
+		}
+		uint32_t seg_len = i - seg_start;
+		if (p_len > 0 && seg_len == 0) {
+			return false;
+		}
+		if (p_str[seg_start] == '.' && (seg_len == 1 || (seg_len == 2 && p_str[seg_start + 1] == '.'))) {
+			return false;
+		}
+		seg_start = i + 1;
+	}
+	return true;
+}
+
+String PackedPathIndex::canonicalize(const String &p_path) {
+	return p_path.simplify_path().trim_prefix("res://");
+}
+
+uint32_t PackedPathIndex::_append_to_arena(const char32_t *p_str, uint32_t p_len) {
+	uint32_t ofs = arena.size();
+	arena.resize(ofs + p_len);
+	memcpy(arena.ptr() + ofs, p_str, p_len * sizeof(char32_t));
+	return ofs;
+}
+
+int64_t PackedPathIndex::_find_slot(const char32_t *p_str, uint32_t p_len, uint64_t p_hash) const {
+	if (slots.is_empty()) {
+		return -1;
+	}
+	uint32_t mask = slots.size() - 1;
+	uint32_t i = p_hash & mask;
+	while (true) {
+		uint32_t idx = slots[i];
+		if (idx == EMPTY_SLOT) {
+			return i;
+		}
+		const Entry &e = entries[idx];
+		if (e.hash == p_hash && e.path_len == p_len && memcmp(_path_ptr(e), p_str, p_len * sizeof(char32_t)) == 0) {
+			return i;
+		}
+		i = (i + 1) & mask;
+	}
+}
+
+int64_t PackedPathIndex::_find(const char32_t *p_str, uint32_t p_len) const {
+	int64_t slot = _find_slot(p_str, p_len, _hash(p_str, p_len));
+	if (slot < 0 || slots[slot] == EMPTY_SLOT) {
+		return -1;
+	}
+	uint32_t idx = slots[slot];
+	return entries[idx].removed ? -1 : idx;
+}
+
+void PackedPathIndex::_grow_slots() {
+	uint32_t new_size = MAX(16u, slots.size() * 2);
+	slots.resize(new_size);
+	for (uint32_t i = 0; i < new_size; i++) {
+		slots[i] = EMPTY_SLOT;
+	}
+	uint32_t mask = new_size - 1;
+	// Removed entries keep their slot so re-adding the same path revives them.
+	for (uint32_t idx = 0; idx < entries.size(); idx++) {
+		uint32_t i = entries[idx].hash & mask;
+		while (slots[i] != EMPTY_SLOT) {
+			i = (i + 1) & mask;
+		}
+		slots[i] = idx;
+	}
+}
+
+int64_t PackedPathIndex::find(const String &p_path) const {
+	const char32_t *str = p_path.get_data();
+	uint32_t len = p_path.length();
+	static constexpr char32_t res_prefix[] = U"res://";
+	if (len >= 6 && memcmp(str, res_prefix, 6 * sizeof(char32_t)) == 0) {
+		str += 6;
+		len -= 6;
+	}
+	if (!_is_canonical(str, len)) {
+		String canonical = canonicalize(p_path);
+		return _find(canonical.get_data(), canonical.length());
+	}
+	return _find(str, len);
+}
+
+void PackedPathIndex::insert(const String &p_path, const String &p_raw_path, bool p_malformed, const PackedData::PackedFile &p_file, bool p_replace) {
+	String key = canonicalize(p_path);
+	const char32_t *str = key.get_data();
+	uint32_t len = key.length();
+	uint64_t h = _hash(str, len);
+
+	if ((entries.size() + 1) * 2 > slots.size()) {
+		_grow_slots();
+	}
+	int64_t slot = _find_slot(str, len, h);
+	Entry *e = nullptr;
+	if (slots[slot] != EMPTY_SLOT) {
+		e = &entries[slots[slot]];
+		if (!e->removed && !p_replace) {
+			return;
+		}
+		if (e->removed) {
+			e->removed = false;
+			live_count++;
+			sorted_dirty = true;
+			ext_buckets_dirty = true;
+		}
+		e->info.unref();
+	} else {
+		slots[slot] = entries.size();
+		entries.push_back(Entry());
+		e = &entries[entries.size() - 1];
+		e->hash = h;
+		e->path_ofs = _append_to_arena(str, len);
+		e->path_len = len;
+		live_count++;
+		sorted_dirty = true;
+		ext_buckets_dirty = true;
+	}
+	e->pf = p_file;
+	e->malformed = p_malformed;
+	e->raw_len = 0;
+	if (p_raw_path.length() != len + 6 || !p_raw_path.begins_with("res://") || !p_raw_path.ends_with(key)) {
+		e->raw_ofs = _append_to_arena(p_raw_path.get_data(), p_raw_path.length());
+		e->raw_len = p_raw_path.length();
+	}
+}
+
+void PackedPathIndex::remove(const String &p_path) {
+	int64_t idx = find(p_path);
+	if (idx < 0) {
+		return;
+	}
+	Entry &e = entries[idx];
+	e.removed = true;
+	e.info.unref();
+	live_count--;
+	sorted_dirty = true;
+	ext_buckets_dirty = true;
+}
+
+void PackedPathIndex::clear() {
+	MutexLock lock(mutex);
+	arena.clear();
+	entries.clear();
+	slots.clear();
+	sorted.clear();
+	ext_buckets.clear();
+	live_count = 0;
+	sorted_dirty = true;
+	ext_buckets_dirty = true;
+}
+
+String PackedPathIndex::get_path(const Entry &p_entry) const {
+	return String(_path_ptr(p_entry), p_entry.path_len);
+}
+
+Ref<PackedFileInfo> PackedPathIndex::get_file_info(uint32_t p_idx) {
+	MutexLock lock(mutex);
+	Entry &e = entries[p_idx];
+	if (e.info.is_null()) {
+		String raw = e.raw_len > 0 ? String(arena.ptr() + e.raw_ofs, e.raw_len) : "res://" + get_path(e);
+		e.info.instantiate();
+		e.info->init(raw, &e.pf);
+	}
+	return e.info;
+}
+
+void PackedPathIndex::_update_sorted() {
+	if (!sorted_dirty) {
+		return;
+	}
+	sorted.clear();
+	sorted.reserve(live_count);
+	for (uint32_t i = 0; i < entries.size(); i++) {
+		if (!entries[i].removed) {
+			sorted.push_back(i);
+		}
+	}
+	SortArray<uint32_t, EntryPathLess> sorter;
+	sorter.compare.arena = arena.ptr();
+	sorter.compare.entries = entries.ptr();
+	sorter.sort(sorted.ptr(), sorted.size());
+	sorted_dirty = false;
+}
+
+void PackedPathIndex::_prefix_range(const String &p_prefix, uint32_t &r_begin, uint32_t &r_end) {
+	_update_sorted();
+	const char32_t *prefix = p_prefix.get_data();
+	uint32_t prefix_len = p_prefix.length();
+	uint32_t lo = 0;
+	uint32_t hi = sorted.size();
+	while (lo < hi) {
+		uint32_t mid = lo + (hi - lo) / 2;
+		const Entry &e = entries[sorted[mid]];
+		if (compare_prefix(_path_ptr(e), e.path_len, prefix, prefix_len) < 0) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	r_begin = lo;
+	hi = sorted.size();
+	while (lo < hi) {
+		uint32_t mid = lo + (hi - lo) / 2;
+		const Entry &e = entries[sorted[mid]];
+		if (compare_prefix(_path_ptr(e), e.path_len, prefix, prefix_len) <= 0) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	r_end = lo;
+}
+
+String PackedPathIndex::_get_file_name(const Entry &p_entry) const {
+	const char32_t *path = _path_ptr(p_entry);
+	uint32_t start = p_entry.path_len;
+	while (start > 0 && path[start - 1] != '/') {
+		start--;
+	}
+	return String(path + start, p_entry.path_len - start);
+}
+
+void PackedPathIndex::_update_ext_buckets() {
+	if (!ext_buckets_dirty) {
+		return;
+	}
+	ext_buckets.clear();
+	for (uint32_t i = 0; i < entries.size(); i++) {
+		const Entry &e = entries[i];
+		if (e.removed) {
+			continue;
+		}
+		const char32_t *path = _path_ptr(e);
+		int64_t dot = -1;
+		for (int64_t j = (int64_t)e.path_len - 1; j >= 0 && path[j] != '/'; j--) {
+			if (path[j] == '.') {
+				dot = j;
+				break;
+			}
+		}
+		String ext = dot < 0 ? String() : String(path + dot + 1, e.path_len - dot - 1).to_lower();
+		ext_buckets[ext].push_back(i);
+	}
+	ext_buckets_dirty = false;
+}
+
+PackedPathIndex::CompiledGlob PackedPathIndex::_compile_glob(const String &p_pattern) {
+	CompiledGlob glob;
+	glob.pattern = p_pattern;
+	int dot = p_pattern.rfind_char('.');
+	if (dot >= 0) {
+		String ext = p_pattern.substr(dot + 1);
+		if (!ext.contains_char('*') && !ext.contains_char('?') && !ext.contains_char('/')) {
+			glob.ext_lower = ext.to_lower();
+			glob.use_bucket = true;
+		}
+	}
+	return glob;
+}
+
+void PackedPathIndex::query_files(const Vector<String> &p_filters, LocalVector<uint32_t> &r_indices) {
+	MutexLock lock(mutex);
+	_update_ext_buckets();
+	LocalVector<CompiledGlob> scan_globs;
+	for (const String &filter : p_filters) {
+		CompiledGlob glob = _compile_glob(filter);
+		if (!glob.use_bucket) {
+			scan_globs.push_back(glob);
+			continue;
+		}
+		const LocalVector<uint32_t> *bucket = ext_buckets.getptr(glob.ext_lower);
+		if (!bucket) {
+			continue;
+		}
+		// The bucket is case-insensitive; match() still decides, exactly as a full scan would.
+		bool literal_star_ext = filter.length() == glob.ext_lower.length() + 2 && filter.begins_with("*.");
+		for (uint32_t idx : *bucket) {
+			if (literal_star_ext) {
+				// The "" bucket also holds names without any dot, which "*." must not match.
+				const Entry &e = entries[idx];
+				const char32_t *ext = _path_ptr(e) + e.path_len - glob.ext_lower.length();
+				if (e.path_len > (uint32_t)glob.ext_lower.length() && ext[-1] == '.' && memcmp(ext, filter.get_data() + 2, glob.ext_lower.length() * sizeof(char32_t)) == 0) {
+					r_indices.push_back(idx);
+				}
+			} else if (_get_file_name(entries[idx]).match(filter)) {
+				r_indices.push_back(idx);
+			}
+		}
+	}
+	if (!scan_globs.is_empty()) {
+		for (uint32_t i = 0; i < entries.size(); i++) {
+			if (entries[i].removed) {
+				continue;
+			}
+			String file = _get_file_name(entries[i]);
+			for (const CompiledGlob &glob : scan_globs) {
+				if (file.match(glob.pattern)) {
+					r_indices.push_back(i);
+					break;
+				}
+			}
+		}
+	}
+	// Several filters can hit the same entry; restore insertion order and drop duplicates.
+	if (p_filters.size() > 1) {
+		r_indices.sort();
+		uint32_t out = 0;
+		for (uint32_t i = 0; i < r_indices.size(); i++) {
+			if (out == 0 || r_indices[out - 1] != r_indices[i]) {
+				r_indices[out++] = r_indices[i];
+			}
+		}
+		r_indices.resize(out);
+	}
+}
+
+bool PackedPathIndex::has_dir(const String &p_dir) {
+	if (p_dir.is_empty()) {
+		return true;
+	}
+	MutexLock lock(mutex);
+	uint32_t begin, end;
+	_prefix_range(p_dir + "/", begin, end);
+	return begin < end;
+}
+
+void PackedPathIndex::list_dir(const String &p_dir, List<String> &r_dirs, List<String> &r_files) {
+	MutexLock lock(mutex);
+	String prefix = p_dir.is_empty() ? String() : p_dir + "/";
+	uint32_t prefix_len = prefix.length();
+	uint32_t begin, end;
+	_prefix_range(prefix, begin, end);
+	const char32_t *last_dir = nullptr;
+	uint32_t last_dir_len = 0;
+	for (uint32_t i = begin; i < end; i++) {
+		const Entry &e = entries[sorted[i]];
+		const char32_t *rest = _path_ptr(e) + prefix_len;
+		uint32_t rest_len = e.path_len - prefix_len;
+		uint32_t slash = 0;
+		while (slash < rest_len && rest[slash] != '/') {
+			slash++;
+		}
+		if (slash == rest_len) {
+			if (rest_len > 0) {
+				r_files.push_back(String(rest, rest_len));
+			}
+			continue;
+		}
+		// Everything under the same subdirectory is contiguous in sorted order.
+		if (last_dir && last_dir_len == slash && memcmp(last_dir, rest, slash * sizeof(char32_t)) == 0) {
+			continue;
+		}
+		last_dir = rest;
+		last_dir_len = slash;
+		r_dirs.push_back(String(rest, slash));
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "core/io/file_access_pack.h"
+#include "core/os/mutex.h"
+#include "core/templates/local_vector.h"
+#include "utility/packed_file_info.h"
+
+// Flat index of every path in the loaded packs.
+// Paths are stored canonicalized (no "res://" prefix) in a single UTF-32 arena and looked up through an
+// open-addressed table of 64-bit FNV-1a hashes, so lookups of canonical paths do not allocate.
+// Directories are not stored; they are ranges of the lexicographically sorted path order, which is rebuilt
+// lazily after the table changes.
+class PackedPathIndex {
+public:
+	struct Entry {
+		PackedData::PackedFile pf;
+		uint64_t hash = 0;
+		uint32_t path_ofs = 0;
+		uint32_t path_len = 0;
+		// Only set when the path in the pack had to be fixed up; otherwise the raw path is "res://" + path.
+		uint32_t raw_ofs = 0;
+		uint32_t raw_len = 0;
+		bool malformed = false;
+		bool removed = false;
+		Ref<PackedFileInfo> info;
+	};
+
+private:
+	static constexpr uint32_t EMPTY_SLOT = UINT32_MAX;
+
+	LocalVector<char32_t> arena;
+	LocalVector<Entry> entries;
+	LocalVector<uint32_t> slots;
+	uint32_t live_count = 0;
+
+	// Guards the lazily built sort order and lazily created file infos.
+	Mutex mutex;
+	LocalVector<uint32_t> sorted;
+	bool sorted_dirty = true;
+	// Live entries bucketed by lowercase extension, in insertion order; rebuilt lazily like the sort order.
+	HashMap<String, LocalVector<uint32_t>> ext_buckets;
+	bool ext_buckets_dirty = true;
+
+	// A file name glob, reduced to an extension bucket when its extension part has no wildcards.
+	struct CompiledGlob {
+		String pattern;
+		String ext_lower;
+		bool use_bucket = false;
+	};
+
+	static uint64_t _hash(const char32_t *p_str, uint32_t p_len);
+	static bool _is_canonical(const char32_t *p_str, uint32_t p_len);
+	_FORCE_INLINE_ const char32_t *_path_ptr(const Entry &p_entry) const { return arena.ptr() + p_entry.path_ofs; }
+	uint32_t _append_to_arena(const char32_t *p_str, uint32_t p_len);
+	int64_t _find_slot(const char32_t *p_str, uint32_t p_len, uint64_t p_hash) const;
+	int64_t _find(const char32_t *p_str, uint32_t p_len) const;
+	void _grow_slots();
+	void _update_sorted();
+	void _update_ext_buckets();
+	static CompiledGlob _compile_glob(const String &p_pattern);
+	String _get_file_name(const Entry &p_entry) const;
+	// Returns the range of sorted entries whose path starts with p_prefix.
+	void _prefix_range(const String &p_prefix, uint32_t &r_begin, uint32_t &r_end);
+
+public:
+	// Strips "res://" and simplifies the path if needed.
+	static String canonicalize(const String &p_path);
+
+	void insert(const String &p_path, const String &p_raw_path, bool p_malformed, const PackedData::PackedFile &p_file, bool p_replace);
+	void remove(const String &p_path);
+	void clear();
+
+	// Returns the entry index or -1; allocation-free for paths already in canonical form.
+	int64_t find(const String &p_path) const;
+	_FORCE_INLINE_ bool has(const String &p_path) const { return find(p_path) != -1; }
+	_FORCE_INLINE_ Entry &get_entry(int64_t p_idx) { return entries[p_idx]; }
+	_FORCE_INLINE_ const Entry &get_entry(int64_t p_idx) const { return entries[p_idx]; }
+	_FORCE_INLINE_ uint32_t size() const { return entries.size(); }
+	_FORCE_INLINE_ bool is_empty() const { return live_count == 0; }
+
+	String get_path(const Entry &p_entry) const;
+	Ref<PackedFileInfo> get_file_info(uint32_t p_idx);
+
+	// Indices of live entries whose file name matches any of p_filters (String::match semantics), in insertion order.
+	// Extension globs like "*.gdc" only visit their extension bucket.
+	void query_files(const Vector<String> &p_filters, LocalVector<uint32_t> &r_indices);
+
+	// p_dir is canonical and without a trailing slash; "" is the root.
+	bool has_dir(const String &p_dir);
+	void list_dir(const String &p_dir, List<String> &r_dirs, List<String> &r_files);
+};
@@ -1,5 +1,6 @@
 #include "pck_creator.h"
 
+#include "core/crypto/crypto_core.h"
 #include "core/error/error_list.h"
 #include "gdre_packed_source.h"
 #include "gdre_settings.h"
@@ -8,6 +9,7 @@
 #include "core/io/file_access.h"
 #include "core/os/os.h"
 #include "utility/common.h"
+#include "utility/file_access_gdre.h"
 #include "utility/packed_file_info.h"
 #include "utility/task_manager.h"
 
@@ -204,17 +206,8 @@ void PckCreator::_do_process_folder(uint32_t i, File *tokens) {
 		}
 		token.size = file->get_length();
 	}
-	if (token.size == 0) {
-		token.md5.resize_initialized(16);
-		return;
-	}
-	auto md5_str = FileAccess::get_md5(path);
-	if (md5_str.is_empty()) {
-		token.err = ERR_FILE_CANT_OPEN;
-		++broken_cnt;
-		return;
-	}
-	token.md5 = md5_str.hex_decode();
+	// The MD5 is computed while the file is copied into the pack, so it doesn't have to be read twice.
+	token.md5.resize_initialized(16);
 }
 
 namespace {
@@ -282,14 +275,13 @@ Error PckCreator::add_files(Dictionary file_paths_to_pack) {
 Error PckCreator::_add_files(
 		const HashMap<String, String> &file_paths_to_pack) {
 	uint64_t start_time = OS::get_singleton()->get_ticks_msec();
-	files_to_pck.resize(file_paths_to_pack.size());
-	Vector<String> keys;
-	keys.resize(file_paths_to_pack.size());
+	// Appends, so this can be combined with _add_raw_files.
+	int64_t start = files_to_pck.size();
+	files_to_pck.resize(start + file_paths_to_pack.size());
 	{
-		size_t i = 0;
+		size_t i = start;
 		for (auto &e : file_paths_to_pack) {
 			files_to_pck.write[i] = { e.value, e.key, 0, 0, encrypt, false, empty_md5 };
-			keys.write[i] = e.key;
 			i++;
 		}
 	}
@@ -297,8 +289,8 @@ Error PckCreator::_add_files(
 	err = TaskManager::get_singleton()->run_multithreaded_group_task(
 			this,
 			&PckCreator::_do_process_folder,
-			files_to_pck.ptrw(),
-			files_to_pck.size(),
+			files_to_pck.ptrw() + start,
+			files_to_pck.size() - start,
 			&PckCreator::get_file_description,
 			"PckCreator::_do_process_folder",
 			"Getting file info...");
@@ -307,7 +299,7 @@ Error PckCreator::_add_files(
 	}
 	if (broken_cnt > 0) {
 		err = ERR_BUG;
-		for (size_t i = 0; i < files_to_pck.size(); i++) {
+		for (size_t i = start; i < files_to_pck.size(); i++) {
 			if (files_to_pck[i].err != OK) {
 				String err_type;
 				if (files_to_pck[i].err == ERR_FILE_CANT_OPEN) {
@@ -328,37 +320,168 @@ Error PckCreator::_add_files(
 		print_error("At least one error was detected while adding files!\n" + error_string);
 		return err;
 	}
-	files_to_pck.resize(files_to_pck.size());
-	for (size_t i = 0; i < files_to_pck.size(); i++) {
+	_assign_offsets(start);
+	bl_print("PCK folder processing took " + itos(OS::get_singleton()->get_ticks_msec() - start_time) + "ms");
+	return OK;
+}
+
+void PckCreator::_assign_offsets(int64_t p_from) {
+	for (int64_t i = p_from; i < files_to_pck.size(); i++) {
+		if (files_to_pck[i].reused) {
+			continue;
+		}
 		files_to_pck.write[i].ofs = offset;
 		uint64_t _size = files_to_pck[i].size;
-		if (encrypt) { // Add encryption overhead.
+		if (files_to_pck[i].encrypted) { // Add encryption overhead.
 			_size += get_encryption_padding(_size);
 		}
 
 		offset += _size;
 		offset += _get_pad(PCK_PADDING, offset);
 	}
-	bl_print("PCK folder processing took " + itos(OS::get_singleton()->get_ticks_msec() - start_time) + "ms");
+}
+
+Error PckCreator::add_raw_files(Dictionary file_paths_to_pack) {
+	HashMap<String, String> map;
+	for (auto &e : file_paths_to_pack.keys()) {
+		map[e] = file_paths_to_pack[e];
+	}
+	return _add_raw_files(map);
+}
+
+Error PckCreator::_add_raw_files(const HashMap<String, String> &file_paths_to_pack) {
+	HashMap<String, String> fallback;
+	int64_t start = files_to_pck.size();
+	for (auto &e : file_paths_to_pack) {
+		PackedData::PackedFile pf;
+		// Pre-v2 directories have no per-file encryption flag.
+		if (!GDREPackedData::get_singleton()->get_pck_entry(e.key, pf) || (pf.encrypted && version < PACK_FORMAT_VERSION_V2)) {
+			fallback[e.key] = e.value;
+			continue;
+		}
+		File file{ e.value, e.key, 0, pf.size, pf.encrypted, false, empty_md5 };
+		memcpy(file.md5.ptrw(), pf.md5, 16);
+		file.raw_pack = pf.pack;
+		file.raw_ofs = pf.offset;
+		files_to_pck.push_back(file);
+	}
+	_assign_offsets(start);
+	if (fallback.is_empty()) {
+		return OK;
+	}
+	return _add_files(fallback);
+}
+
+// Writes the FileAccessEncrypted layout (MD5, size, IV, AES-256-CFB data padded to the block size) one buffer at a
+// time. FileAccessEncrypted itself holds the whole plaintext until it is closed, which doesn't scale to one large
+// file per pool thread.
+Error PckCreator::_encrypt_and_write_file(File &p_file, Ref<FileAccess> write_handle) {
+	Error error;
+	Ref<FileAccess> fa = FileAccess::open(p_file.src_path, FileAccess::READ, &error);
+	if (!fa.is_valid()) {
+		return error ? error : ERR_FILE_CANT_OPEN;
+	}
+	uint8_t iv[16];
+	{
+		CryptoCore::RandomGenerator rng;
+		ERR_FAIL_COND_V(rng.init() != OK, ERR_CANT_CREATE);
+		ERR_FAIL_COND_V(rng.get_random_bytes(iv, 16) != OK, ERR_CANT_CREATE);
+	}
+	CryptoCore::AESContext ctx;
+	ERR_FAIL_COND_V(ctx.set_encode_key(key.ptr(), 256) != OK, ERR_INVALID_PARAMETER);
+
+	// The MD5 goes first but is only known at the end; it is filled in afterwards.
+	uint64_t header_pos = write_handle->get_position();
+	static const uint8_t zeros[16] = {};
+	write_handle->store_buffer(zeros, 16);
+	write_handle->store_64(p_file.size);
+	write_handle->store_buffer(iv, 16);
+
+	CryptoCore::MD5Context md5;
+	md5.start();
+	int64_t rq_size = p_file.size;
+	uint8_t buf[piecemeal_read_size]; // A multiple of the AES block size, so chunks chain without carrying state.
+	while (rq_size > 0) {
+		uint64_t want = MIN(piecemeal_read_size, rq_size);
+		uint64_t got = fa->get_buffer(buf, want);
+		if (got != want) {
+			// The file shrank since its size was taken.
+			return ERR_FILE_CANT_OPEN;
+		}
+		md5.update(buf, got);
+		uint64_t padded = got;
+		if (padded % 16) {
+			padded += 16 - (padded % 16);
+			memset(buf + got, 0, padded - got);
+		}
+		ERR_FAIL_COND_V(ctx.encrypt_cfb(padded, iv, buf, buf) != OK, ERR_CANT_CREATE);
+		write_handle->store_buffer(buf, padded);
+		rq_size -= got;
+	}
+	uint8_t hash[16];
+	md5.finish(hash);
+	// Empty files keep an all-zero MD5 in the directory, as before; the encryption header needs the real one.
+	if (p_file.size > 0) {
+		memcpy(p_file.md5.ptrw(), hash, 16);
+	}
+	uint64_t end = write_handle->get_position();
+	write_handle->seek(header_pos);
+	write_handle->store_buffer(hash, 16);
+	write_handle->seek(end);
 	return OK;
 }
 
-Error PckCreator::read_and_write_file(size_t i, Ref<FileAccess> write_handle) {
+// Copies the entry's stored bytes (ciphertext and encryption header included) from its source pack.
+Error PckCreator::_copy_raw_file(const File &p_file, Ref<FileAccess> write_handle) {
 	Error error;
-	Ref<FileAccess> fa = FileAccess::open(files_to_pck[i].src_path, FileAccess::READ, &error);
+	Ref<FileAccess> fa = FileAccess::open(p_file.raw_pack, FileAccess::READ, &error);
 	if (!fa.is_valid()) {
 		return error ? error : ERR_FILE_CANT_OPEN;
 	}
-	int64_t rq_size = files_to_pck[i].size;
+	fa->seek(p_file.raw_ofs);
+	int64_t rq_size = p_file.size;
+	if (p_file.encrypted) {
+		rq_size += get_encryption_padding(p_file.size);
+	}
 	uint8_t buf[piecemeal_read_size];
 	while (rq_size > 0) {
 		uint64_t got = fa->get_buffer(buf, MIN(piecemeal_read_size, rq_size));
+		if (got == 0) {
+			return ERR_FILE_CANT_OPEN;
+		}
 		write_handle->store_buffer(buf, got);
 		rq_size -= got;
 	}
 	return OK;
 }
 
+Error PckCreator::read_and_write_file(File &p_file, Ref<FileAccess> write_handle) {
+	Error error;
+	Ref<FileAccess> fa = FileAccess::open(p_file.src_path, FileAccess::READ, &error);
+	if (!fa.is_valid()) {
+		return error ? error : ERR_FILE_CANT_OPEN;
+	}
+	CryptoCore::MD5Context md5;
+	md5.start();
+	int64_t rq_size = p_file.size;
+	uint8_t buf[piecemeal_read_size];
+	while (rq_size > 0) {
+		uint64_t got = fa->get_buffer(buf, MIN(piecemeal_read_size, rq_size));
+		if (got == 0) {
+			// The file shrank since its size was taken.
+			return ERR_FILE_CANT_OPEN;
+		}
+		md5.update(buf, got);
+		write_handle->store_buffer(buf, got);
+		rq_size -= got;
+	}
+	// Empty files keep an all-zero MD5, as before.
+	if (p_file.size > 0) {
+		md5.finish(p_file.md5.ptrw());
+	}
+	return OK;
+}
+
 Error PckCreator::finish_pck() {
 	Error error = _create_after_process();
 	ERR_FAIL_COND_V_MSG(error && error != ERR_SKIP && error != ERR_PRINTER_ON_FIRE, error, "Error creating pck: " + error_string);
@@ -369,30 +492,57 @@ String PckCreator::get_file_description(int64_t i, File *userdata) {
 	return userdata[i].src_path;
 }
 
+Ref<FileAccess> PckCreator::_acquire_write_handle() {
+	{
+		MutexLock lock(write_handle_mutex);
+		if (!write_handles.is_empty()) {
+			Ref<FileAccess> handle = write_handles[write_handles.size() - 1];
+			write_handles.resize(write_handles.size() - 1);
+			return handle;
+		}
+	}
+	return FileAccess::open(write_path, FileAccess::READ_WRITE);
+}
+
+void PckCreator::_release_write_handle(const Ref<FileAccess> &p_handle) {
+	MutexLock lock(write_handle_mutex);
+	write_handles.push_back(p_handle);
+}
+
 void PckCreator::_do_write_file(uint32_t i, File *files_to_pck) {
-	if (unlikely(cancelled)) {
+	if (unlikely(cancelled) || files_to_pck[i].reused) {
 		return;
 	}
 	if (encryption_error != OK) {
 		return;
 	}
-	DEV_ASSERT(f->get_position() == files_start + files_to_pck[i].ofs);
-	Ref<FileAccessEncrypted> fae;
-	Ref<FileAccess> ftmp = f;
-	if (encrypt) {
-		fae.instantiate();
-
-		files_to_pck[i].err = fae->open_and_parse(f, key, FileAccessEncrypted::MODE_WRITE_AES256, false);
-		if (files_to_pck[i].err != OK) {
-			encryption_error = files_to_pck[i].err;
+	// Offsets are all known up front, so each task writes at its own position through a handle of its own.
+	Ref<FileAccess> handle = _acquire_write_handle();
+	if (handle.is_null()) {
+		files_to_pck[i].err = ERR_FILE_CANT_WRITE;
+		MutexLock lock(error_mutex);
+		error_string += files_to_pck[i].path + " (File write error)\n";
+		broken_cnt++;
+		cancelled = true;
+		return;
+	}
+	handle->seek(files_start + files_to_pck[i].ofs);
+	if (!files_to_pck[i].raw_pack.is_empty()) {
+		files_to_pck[i].err = _copy_raw_file(files_to_pck[i], handle);
+	} else if (files_to_pck[i].encrypted) {
+		if (key.size() != 32) {
+			files_to_pck[i].err = ERR_INVALID_PARAMETER;
+			encryption_error = ERR_INVALID_PARAMETER;
 			broken_cnt++;
 			cancelled = true;
 			return;
 		}
-		ftmp = fae;
+		files_to_pck[i].err = _encrypt_and_write_file(files_to_pck[i], handle);
+	} else {
+		files_to_pck[i].err = read_and_write_file(files_to_pck[i], handle);
 	}
-	files_to_pck[i].err = read_and_write_file(i, ftmp);
 	if (files_to_pck[i].err != OK) {
+		MutexLock lock(error_mutex);
 		switch (files_to_pck[i].err) {
 			case ERR_FILE_CANT_OPEN:
 				error_string += files_to_pck[i].path + " (File read error)\n";
@@ -409,15 +559,31 @@ void PckCreator::_do_write_file(uint32_t i, File *files_to_pck) {
 		return;
 	}
 
-	if (fae.is_valid()) {
-		ftmp.unref();
-		fae.unref();
-	}
+	// The output was preallocated with zeros, so the padding after each file is already in place.
+	_release_write_handle(handle);
+}
 
-	int pad = _get_pad(PCK_PADDING, f->get_position());
-	for (int j = 0; j < pad; j++) {
-		f->store_8(0);
+bool PckCreator::_check_append_in_place() {
+	if (embed || version < PACK_FORMAT_VERSION_V3) {
+		WARN_PRINT("In-place patching needs a standalone PCK of format v3 or later, rewriting the whole file instead.");
+		return false;
+	}
+	Ref<FileAccess> fa = FileAccess::open(pck_path, FileAccess::READ);
+	if (fa.is_null()) {
+		return false;
+	}
+	uint32_t expected_flags = PACK_REL_FILEBASE | (encrypt ? PACK_DIR_ENCRYPTED : 0);
+	if (fa->get_32() != 0x43504447 || fa->get_32() != (uint32_t)version) {
+		WARN_PRINT("Not a standalone PCK of the same format version, rewriting the whole file instead: " + pck_path);
+		return false;
 	}
+	fa->seek(20);
+	if (fa->get_32() != expected_flags) {
+		WARN_PRINT("PCK flags differ from the ones being written, rewriting the whole file instead: " + pck_path);
+		return false;
+	}
+	append_file_base = fa->get_64();
+	return true;
 }
 
 Error PckCreator::_create_after_process() {
@@ -437,12 +603,18 @@ Error PckCreator::_create_after_process() {
 		return ERR_FILE_NOT_FOUND;
 	}
 
+	bool append = in_place && _check_append_in_place();
+	if (append) {
+		// The pack being patched is usually the one that is loaded; Windows won't open it for writing while mapped.
+		GDREPackedData::get_singleton()->release_pack_mapping(pck_path);
+	}
+
 	// create a tmp file if the pck file already exists
-	if (FileAccess::exists(pck_path) || exe_to_embed.simplify_path() == pck_path.simplify_path()) {
+	if (!append && (FileAccess::exists(pck_path) || exe_to_embed.simplify_path() == pck_path.simplify_path())) {
 		temp_path = pck_path + ".tmp";
 	}
 
-	f = FileAccess::open(temp_path, FileAccess::WRITE);
+	f = FileAccess::open(temp_path, append ? FileAccess::READ_WRITE : FileAccess::WRITE);
 	if (f.is_null()) {
 		error_string = ("Error opening PCK file: ") + temp_path;
 		return ERR_FILE_CANT_WRITE;
@@ -486,16 +658,23 @@ Error PckCreator::_create_after_process() {
 	}
 	pck_start_pos = f->get_position();
 
-	f->store_32(0x43504447); //GDPK
-	f->store_32(version);
-	f->store_32(ver_major);
-	f->store_32(ver_minor);
-	f->store_32(ver_rev);
-
 	int64_t file_base_ofs = 0;
 	int64_t dir_base_ofs = 0;
 	uint32_t pack_flags = version >= PACK_FORMAT_VERSION_V3 ? PACK_REL_FILEBASE : 0;
-	if (version >= PACK_FORMAT_VERSION_V2) {
+	if (append) {
+		// The existing header and data are kept; everything new goes after the end of the file.
+		pack_flags |= encrypt ? PACK_DIR_ENCRYPTED : 0;
+		file_base_ofs = pck_start_pos + 24;
+		dir_base_ofs = pck_start_pos + 32;
+		f->seek_end();
+	} else {
+		f->store_32(0x43504447); //GDPK
+		f->store_32(version);
+		f->store_32(ver_major);
+		f->store_32(ver_minor);
+		f->store_32(ver_rev);
+	}
+	if (version >= PACK_FORMAT_VERSION_V2 && !append) {
 		if (encrypt) {
 			pack_flags |= PACK_DIR_ENCRYPTED;
 		}
@@ -508,7 +687,7 @@ Error PckCreator::_create_after_process() {
 		}
 	}
 
-	for (size_t i = 0; i < 16; i++) {
+	for (size_t i = 0; i < 16 && !append; i++) {
 		//reserved
 		f->store_32(0);
 	}
@@ -606,7 +785,12 @@ Error PckCreator::_create_after_process() {
 		return OK;
 	};
 
+	uint64_t dir_offset = 0;
+	// Before v3 the directory comes before the data, but the MD5s are only known once the data is written. The
+	// directory's size doesn't depend on them, so write it now and rewrite it in place afterwards.
+	uint64_t pre_v3_dir_pos = 0;
 	if (version < PACK_FORMAT_VERSION_V3) {
+		pre_v3_dir_pos = f->get_position();
 		Error err = write_header();
 		if (err != OK) {
 			return err;
@@ -619,14 +803,47 @@ Error PckCreator::_create_after_process() {
 		}
 	}
 
-	files_start = f->get_position();
-	file_base = files_start - ((pack_flags & PACK_REL_FILEBASE) != 0 ? pck_start_pos : 0);
+	if (append) {
+		// Offsets stay relative to the existing file base. Entries already in this pack keep pointing at their
+		// current data; the rest are laid out again from the end of the file.
+		file_base = append_file_base;
+		files_start = pck_start_pos + file_base;
+		String simplified_pck_path = pck_path.simplify_path();
+		int64_t reused_cnt = 0;
+		for (int64_t i = 0; i < files_to_pck.size(); i++) {
+			File &file = files_to_pck.write[i];
+			if (!file.raw_pack.is_empty() && file.raw_pack.simplify_path() == simplified_pck_path) {
+				file.reused = true;
+				file.ofs = file.raw_ofs - files_start;
+				reused_cnt++;
+			}
+		}
+		if (reused_cnt == 0 && !files_to_pck.is_empty()) {
+			// Every entry gets appended again, roughly doubling the file; the source pack was probably given by a
+			// different path than the one it was loaded from.
+			WARN_PRINT("In-place patching reuses no entries of " + pck_path + ", all files are appended again.");
+		}
+		offset = f->get_position() - files_start;
+		_assign_offsets(0);
+	} else {
+		files_start = f->get_position();
+		file_base = files_start - ((pack_flags & PACK_REL_FILEBASE) != 0 ? pck_start_pos : 0);
+	}
 	// DEV_ASSERT(file_base == header_size + header_padding);
-	if (version >= PACK_FORMAT_VERSION_V2) {
+	if (version >= PACK_FORMAT_VERSION_V2 && !append) {
 		f->seek(file_base_ofs);
 		f->store_64(file_base); // update files base
-		f->seek(files_start);
 	}
+	// Extend the file over the data section, so the writer tasks can fill it in any order. Where the filesystem
+	// supports it the space is actually reserved; otherwise the gap is left sparse.
+	uint64_t data_end = files_start + offset;
+	f->flush();
+	if (gdre::preallocate_file(temp_path, data_end) != OK && f->resize(data_end) != OK) {
+		error_string = "Error preallocating PCK file: " + temp_path;
+		f = nullptr;
+		return ERR_FILE_CANT_WRITE;
+	}
+	write_path = temp_path;
 
 	Error err = TaskManager::get_singleton()->run_multithreaded_group_task(
 			this,
@@ -637,9 +854,15 @@ Error PckCreator::_create_after_process() {
 			"Writing files...",
 			"Writing files...",
 			true,
-			1, // single-threaded, but runs on the thread pool
+			-1,
 			true,
 			pr);
+	{
+		// Closing the handles flushes them.
+		MutexLock lock(write_handle_mutex);
+		write_handles.clear();
+	}
+	f->seek(data_end);
 	if (err) { // cancelled
 		f = nullptr;
 		return err;
@@ -655,16 +878,20 @@ Error PckCreator::_create_after_process() {
 		return ERR_FILE_CANT_WRITE;
 	}
 
-	if (version >= PACK_FORMAT_VERSION_V3) {
+	if (version < PACK_FORMAT_VERSION_V3) {
+		f->seek(pre_v3_dir_pos);
+		if (write_header() != OK) {
+			return ERR_FILE_CANT_WRITE;
+		}
+		DEV_ASSERT(f->get_position() == files_start);
+		f->seek(data_end);
+	} else {
 		int dir_padding = _get_pad(PCK_PADDING, f->get_position());
 		for (int i = 0; i < dir_padding; i++) {
 			f->store_8(0);
 		}
 
-		uint64_t dir_offset = f->get_position();
-		f->seek(dir_base_ofs);
-		f->store_64(dir_offset - pck_start_pos); // update directory base
-		f->seek(dir_offset);
+		dir_offset = f->get_position();
 		if (write_header() != OK) {
 			return ERR_FILE_CANT_WRITE;
 		}
@@ -722,7 +949,24 @@ Error PckCreator::_create_after_process() {
 			WARN_PRINT("There is data at the end of the executable past the pck, this data will be lost!");
 		}
 	}
+	if (version >= PACK_FORMAT_VERSION_V3) {
+		// Point the header at the new directory only once everything it refers to is on disk. When appending in
+		// place, the old directory stays valid until this single write.
+		f->flush();
+		if (append && gdre::sync_file(temp_path) != OK) {
+			error_string = "Error syncing PCK file: " + temp_path;
+			f = nullptr;
+			return ERR_FILE_CANT_WRITE;
+		}
+		f->seek(dir_base_ofs);
+		f->store_64(dir_offset - pck_start_pos); // update directory base
+	}
 	f->flush();
+	if (append && gdre::sync_file(temp_path) != OK) {
+		error_string = "Error syncing PCK file: " + temp_path;
+		f = nullptr;
+		return ERR_FILE_CANT_WRITE;
+	}
 	f = nullptr;
 	if (temp_path != pck_path) {
 		if (GDRESettings::get_singleton()->is_pack_loaded()) {
@@ -752,6 +996,7 @@ void PckCreator::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("reset"), &PckCreator::reset);
 	ClassDB::bind_method(D_METHOD("start_pck", "pck_path", "pck_version", "ver_major", "ver_minor", "ver_rev", "encrypt", "embed", "exe_to_embed", "watermark"), &PckCreator::start_pck, DEFVAL(false), DEFVAL(false), DEFVAL(""), DEFVAL(""));
 	ClassDB::bind_method(D_METHOD("add_files", "file_paths_to_pack"), &PckCreator::add_files);
+	ClassDB::bind_method(D_METHOD("add_raw_files", "file_paths_to_pack"), &PckCreator::add_raw_files);
 	ClassDB::bind_method(D_METHOD("finish_pck"), &PckCreator::finish_pck);
 	ClassDB::bind_method(D_METHOD("set_pack_version", "ver"), &PckCreator::set_pack_version);
 	ClassDB::bind_method(D_METHOD("get_pack_version"), &PckCreator::get_pack_version);
@@ -767,6 +1012,8 @@ void PckCreator::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("get_embed"), &PckCreator::get_embed);
 	ClassDB::bind_method(D_METHOD("set_exe_to_embed", "exe"), &PckCreator::set_exe_to_embed);
 	ClassDB::bind_method(D_METHOD("get_exe_to_embed"), &PckCreator::get_exe_to_embed);
+	ClassDB::bind_method(D_METHOD("set_in_place", "in_place"), &PckCreator::set_in_place);
+	ClassDB::bind_method(D_METHOD("get_in_place"), &PckCreator::get_in_place);
 	ClassDB::bind_method(D_METHOD("set_watermark", "watermark"), &PckCreator::set_watermark);
 	ClassDB::bind_method(D_METHOD("get_watermark"), &PckCreator::get_watermark);
 	ClassDB::bind_method(D_METHOD("get_error_message"), &PckCreator::get_error_message);
@@ -779,5 +1026,6 @@ void PckCreator::_bind_methods() {
 	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "embed"), "set_embed", "get_embed");
 	ADD_PROPERTY(PropertyInfo(Variant::STRING, "exe_to_embed"), "set_exe_to_embed", "get_exe_to_embed");
 	ADD_PROPERTY(PropertyInfo(Variant::STRING, "watermark"), "set_watermark", "get_watermark");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "in_place"), "set_in_place", "get_in_place");
 	//ClassDB::bind_method(D_METHOD("get_dumped_files"), &PckCreator::get_dumped_files);
 }
@@ -3,6 +3,8 @@
 
 #include "core/object/object.h"
 #include "core/object/ref_counted.h"
+#include "core/os/mutex.h"
+#include "core/templates/local_vector.h"
 #include "packed_file_info.h"
 
 #include <core/variant/typed_dictionary.h>
@@ -19,6 +21,9 @@ class PckCreator : public RefCounted {
 	bool embed = false;
 	String exe_to_embed;
 	String watermark;
+	// Patch an existing standalone v3 PCK by appending new data and a new directory instead of rewriting it.
+	bool in_place = false;
+	uint64_t append_file_base = 0;
 	struct File {
 		String path;
 		String src_path;
@@ -28,6 +33,11 @@ class PckCreator : public RefCounted {
 		bool removal = false;
 		Vector<uint8_t> md5;
 		Error err = OK;
+		// Set for entries copied verbatim from a loaded PCK: the pack file and the absolute offset of the stored bytes.
+		String raw_pack;
+		uint64_t raw_ofs = 0;
+		// In-place patching: the data already sits in the pack being patched and is left where it is.
+		bool reused = false;
 	};
 
 	Vector<File> files_to_pck;
@@ -38,6 +48,11 @@ class PckCreator : public RefCounted {
 	std::atomic<int64_t> data_read = 0;
 	Vector<String> tmp_files;
 	Ref<FileAccess> f;
+	// File data is written by parallel tasks, each through its own handle to the output; handles are reused.
+	String write_path;
+	Mutex write_handle_mutex;
+	LocalVector<Ref<FileAccess>> write_handles;
+	Mutex error_mutex;
 	size_t pck_start_pos = 0;
 	size_t files_start = 0;
 	size_t file_base = 0;
@@ -52,9 +67,16 @@ class PckCreator : public RefCounted {
 	void _do_process_folder(uint32_t i, File *tokens);
 	String get_file_description(int64_t i, File *userdata);
 
+	Ref<FileAccess> _acquire_write_handle();
+	void _release_write_handle(const Ref<FileAccess> &p_handle);
 	void _do_write_file(uint32_t i, File *tokens);
 
-	inline Error read_and_write_file(size_t i, Ref<FileAccess> write_handle);
+	// Copies the file into the pack and fills in its MD5 from the same read.
+	Error read_and_write_file(File &p_file, Ref<FileAccess> write_handle);
+	Error _encrypt_and_write_file(File &p_file, Ref<FileAccess> write_handle);
+	Error _copy_raw_file(const File &p_file, Ref<FileAccess> write_handle);
+	void _assign_offsets(int64_t p_from);
+	bool _check_append_in_place();
 	Error headless_pck_create(const String &pck_path, const String &dir, const Vector<String> &include_filters, const Vector<String> &exclude_filters);
 	Error non_headless_pck_create(const String &pck_path, const String &dir, const Vector<String> &include_filters, const Vector<String> &exclude_filters);
 
@@ -67,6 +89,10 @@ public:
 	void start_pck(const String &p_pck_path, int pck_version, int ver_major, int ver_minor, int ver_rev, bool encrypt = false, bool embed = false, const String &exe_to_embed = "", const String &watermark = "");
 	Error add_files(Dictionary file_paths_to_pack);
 	Error _add_files(const HashMap<String, String> &file_paths_to_pack);
+	// Like add_files, but the sources are paths in the loaded PCK whose stored bytes are copied as they are, without
+	// decrypting or re-encrypting; the MD5 comes from the source directory. Paths not stored in a PCK are added normally.
+	Error add_raw_files(Dictionary file_paths_to_pack);
+	Error _add_raw_files(const HashMap<String, String> &file_paths_to_pack);
 	Error finish_pck();
 	Error pck_create(const String &p_pck_path, const String &p_dir, const Vector<String> &include_filters, const Vector<String> &exclude_filters);
 	Error _create_after_process();
@@ -86,6 +112,8 @@ public:
 	String get_exe_to_embed() const { return exe_to_embed; }
 	void set_watermark(const String &wm) { watermark = wm; }
 	String get_watermark() const { return watermark; }
+	void set_in_place(bool p_in_place) { in_place = p_in_place; }
+	bool get_in_place() const { return in_place; }
 	String get_error_message() const { return error_string; }
 };
 
@@ -1,10 +1,15 @@
 #include "pck_dumper.h"
+#include "core/crypto/crypto_core.h"
 #include "core/error/error_list.h"
+#include "core/os/os.h"
 #include "gdre_settings.h"
 
 #include "core/io/dir_access.h"
 #include "core/io/file_access.h"
 #include "utility/common.h"
+#include "utility/extract_sink.h"
+#include "utility/file_access_gdre.h"
+#include "utility/file_access_mapped.h"
 #include "utility/packed_file_info.h"
 
 #include <utility/gdre_standalone.h>
@@ -12,6 +17,17 @@
 
 const static Vector<uint8_t> empty_md5 = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
 
+static TaskManager::IOLocalityKey get_file_locality(const Ref<PackedFileInfo> &p_file) {
+	return { p_file->get_pack(), p_file->get_offset() };
+}
+
+template <typename T>
+void PckDumper::_prefetch_ahead(uint32_t i, const T *p_items) {
+	if (i + PREFETCH_AHEAD < token_count) {
+		GDREPackedData::get_singleton()->prefetch_file(_get_item_file(p_items[i + PREFETCH_AHEAD])->pf);
+	}
+}
+
 bool PckDumper::_pck_file_check_md5(Ref<PackedFileInfo> &file) {
 	auto hash = FileAccess::get_md5(file->get_path());
 	auto p_md5 = String::md5(file->get_md5().ptr());
@@ -33,6 +49,7 @@ void PckDumper::_do_md5_check(uint32_t i, Ref<PackedFileInfo> *tokens) {
 	// if (unlikely(cancelled)) {
 	// 	return;
 	// }
+	_prefetch_ahead(i, tokens);
 	if (tokens[i]->get_md5() == empty_md5) {
 		skipped_cnt++;
 	} else {
@@ -47,8 +64,10 @@ void PckDumper::_do_md5_check(uint32_t i, Ref<PackedFileInfo> *tokens) {
 
 void PckDumper::reset() {
 	completed_cnt = 0;
+	token_count = 0;
 	skipped_cnt = 0;
 	broken_cnt = 0;
+	unchanged_cnt = 0;
 	output_dir = "";
 }
 
@@ -63,6 +82,8 @@ Error PckDumper::_check_md5_all_files(Vector<String> &broken_files, int &checked
 	}
 	Error err = OK;
 	auto files = GDRESettings::get_singleton()->get_file_info_list();
+	TaskManager::sort_by_io_locality(files, get_file_locality);
+	token_count = files.size();
 	int skipped_files = 0;
 	String task_desc;
 	if (GDRESettings::get_singleton()->is_headless()) {
@@ -112,65 +133,292 @@ Error PckDumper::_check_md5_all_files(Vector<String> &broken_files, int &checked
 	}
 	return err;
 }
-Error PckDumper::pck_dump_to_dir(const String &dir, const Vector<String> &files_to_extract = Vector<String>()) {
+Error PckDumper::pck_dump_to_dir(const String &dir, const Vector<String> &files_to_extract = Vector<String>(), bool verify_md5, bool incremental) {
 	String t;
-	return _pck_dump_to_dir(dir, files_to_extract, t);
+	return _pck_dump_to_dir(dir, files_to_extract, t, verify_md5, incremental);
 }
 
-void PckDumper::_do_extract(uint32_t i, ExtractToken *tokens) {
-	auto &file = tokens[i].file;
-	const auto &dir = output_dir;
-	Error err = OK;
-	Ref<FileAccess> pck_f = FileAccess::open(file->get_path(), FileAccess::READ, &err);
-	if (err || pck_f.is_null()) {
-		broken_cnt++;
-		completed_cnt++;
-		tokens[i].err = ERR_FILE_CANT_OPEN;
-		return;
+String PckDumper::_get_file_signature(const Ref<PackedFileInfo> &p_file) {
+	if (p_file->has_md5()) {
+		return String::md5(p_file->pf.md5);
+	}
+	// No checksum in the directory, so hash the entry itself; a rebuilt pack can change a file in place.
+	return FileAccess::get_md5(p_file->get_path());
+}
+
+void PckDumper::_load_manifest() {
+	manifest.clear();
+	String manifest_path = output_dir.path_join(MANIFEST_NAME);
+	Ref<FileAccess> f = FileAccess::open(manifest_path, FileAccess::READ);
+	if (f.is_valid()) {
+		// Later lines win, so journaled entries from an interrupted run override the compacted ones.
+		while (!f->eof_reached()) {
+			Vector<String> parts = f->get_line().split("\t", true, 3);
+			if (parts.size() != 4) {
+				continue;
+			}
+			manifest[parts[3]] = { parts[0], (uint64_t)parts[1].to_int(), (uint64_t)parts[2].to_int() };
+		}
+		f = FileAccess::open(manifest_path, FileAccess::READ_WRITE);
+		if (f.is_valid()) {
+			f->seek_end();
+		}
+	} else {
+		f = FileAccess::open(manifest_path, FileAccess::WRITE);
+	}
+	manifest_journal = f;
+}
+
+void PckDumper::_record_manifest(const String &p_path, const ManifestEntry &p_entry) {
+	MutexLock lock(manifest_mutex);
+	manifest[p_path] = p_entry;
+	if (manifest_journal.is_valid()) {
+		manifest_journal->store_line(vformat("%s\t%d\t%d\t%s", p_entry.signature, (int64_t)p_entry.size, (int64_t)p_entry.mtime, p_path));
+	}
+}
+
+void PckDumper::_finish_manifest() {
+	manifest_journal.unref();
+	// Rewrite the journal without superseded entries.
+	Ref<FileAccess> f = FileAccess::open(output_dir.path_join(MANIFEST_NAME), FileAccess::WRITE);
+	ERR_FAIL_COND_MSG(f.is_null(), "Failed to write extraction manifest to " + output_dir);
+	for (const KeyValue<String, ManifestEntry> &E : manifest) {
+		f->store_line(vformat("%s\t%d\t%d\t%s", E.value.signature, (int64_t)E.value.size, (int64_t)E.value.mtime, E.key));
+	}
+	manifest.clear();
+}
+
+bool PckDumper::_is_up_to_date(const Ref<PackedFileInfo> &p_file, const String &p_target) {
+	Ref<FileAccess> f = FileAccess::open(p_target, FileAccess::READ);
+	if (f.is_null() || f->get_length() != p_file->get_size()) {
+		return false;
+	}
+	f.unref();
+	uint64_t mtime = FileAccess::get_modified_time(p_target);
+	String recorded_signature;
+	bool has_record = false;
+	{
+		MutexLock lock(manifest_mutex);
+		const ManifestEntry *recorded = manifest.getptr(p_file->get_path());
+		if (recorded) {
+			if (recorded->size != p_file->get_size() || recorded->mtime != mtime) {
+				return false;
+			}
+			recorded_signature = recorded->signature;
+			has_record = true;
+		}
+	}
+	if (has_record) {
+		// Entries without a directory MD5 are read and hashed here; that still saves rewriting them.
+		return recorded_signature == _get_file_signature(p_file);
+	}
+	// Not extracted by us (or the manifest was lost); with a checksum, the existing file can still be compared.
+	if (p_file->has_md5()) {
+		String signature = _get_file_signature(p_file);
+		if (FileAccess::get_md5(p_target) == signature) {
+			_record_manifest(p_file->get_path(), { signature, p_file->get_size(), mtime });
+			return true;
+		}
 	}
+	return false;
+}
+
+void PckDumper::_fail_token(ExtractToken &p_token, Error p_err) {
+	p_token.err = p_err;
+	p_token.data.clear();
+	broken_cnt++;
+	completed_cnt++;
+}
+
+void PckDumper::_finish_token(ExtractToken &p_token) {
+	auto &file = p_token.file;
+	if (p_token.hashed && should_check_md5 && file->has_md5()) {
+		p_token.md5_passed = memcmp(p_token.md5, file->pf.md5, 16) == 0;
+		file->set_md5_match(p_token.md5_passed);
+		if (!p_token.md5_passed) {
+			if (file->is_encrypted()) {
+				encryption_error = true;
+			}
+			print_error("Checksum failed for " + file->get_path());
+			broken_cnt++;
+			p_token.err = ERR_FILE_CORRUPT;
+		}
+	}
+	if (incremental && p_token.err == OK) {
+		String signature = file->has_md5() ? String::md5(file->pf.md5) : String::md5(p_token.md5);
+		_record_manifest(file->get_path(), { signature, file->get_size(), FileAccess::get_modified_time(p_token.target) });
+	}
+	p_token.data.clear();
+	completed_cnt++;
+	if (file->is_malformed() && file->get_raw_path() != file->get_path()) {
+		print_line("Warning: " + file->get_raw_path() + " is a malformed path!\nSaving to " + file->get_path() + " instead.");
+	}
+	print_verbose("Extracted " + p_token.target);
+}
+
+// Streams an entry to the sink in chunks, hashing along the way if needed.
+Error PckDumper::_copy_entry(ExtractToken &p_token, Ref<FileAccess> p_src) {
+	CryptoCore::MD5Context md5;
+	if (p_token.hashed) {
+		md5.start();
+	}
+	Error err = sink->write_file_from(p_token.rel_path, p_src, p_token.file->get_size(), p_token.hashed ? &md5 : nullptr);
+	if (err == ERR_FILE_CANT_READ) {
+		// The pack entry ended early.
+		return ERR_FILE_CANT_OPEN;
+	} else if (err == ERR_FILE_CORRUPT) {
+		// Decrypted data that doesn't match the directory's MD5: a wrong key or a corrupt pack.
+		if (p_token.file->is_encrypted()) {
+			encryption_error = true;
+		}
+		return err;
+	} else if (err != OK) {
+		return err;
+	}
+	if (p_token.hashed) {
+		md5.finish(p_token.md5);
+	}
+	return OK;
+}
+
+// Reader stage: runs on the worker pool, does the pack reads, decryption and hashing, and hands small entries to
+// the writers. Entries too large to buffer are streamed to disk right here.
+void PckDumper::_do_extract(uint32_t i, ExtractToken *tokens) {
+	_prefetch_ahead(i, tokens);
+	ExtractToken &token = tokens[i];
+	auto &file = token.file;
 	String path = file->get_path();
 	if (path.begins_with("user://")) {
 		path = path.replace_first("user://", ".user/");
 	}
-	String target_name = dir.path_join(path.trim_prefix("res://"));
-	err = gdre::ensure_dir(target_name.get_base_dir());
-	if (err != OK) {
-		broken_cnt++;
+	token.rel_path = path.trim_prefix("res://");
+	token.target = sink->get_target_path(token.rel_path);
+	if (incremental && _is_up_to_date(file, token.target)) {
+		unchanged_cnt++;
 		completed_cnt++;
-		tokens[i].err = ERR_CANT_CREATE;
 		return;
 	}
-	Ref<FileAccess> fa = FileAccess::open(target_name, FileAccess::WRITE, &err);
-	if (err || fa.is_null()) {
-		broken_cnt++;
-		completed_cnt++;
-		tokens[i].err = ERR_FILE_CANT_WRITE;
+	Error err = OK;
+	// Everything below reads the entry once, in order, and checks for errors afterwards.
+	Ref<FileAccess> pck_f = GDREPackedData::get_singleton()->open_sequential(file->get_path());
+	if (pck_f.is_null()) {
+		pck_f = FileAccess::open(file->get_path(), FileAccess::READ, &err);
+	}
+	if (err || pck_f.is_null()) {
+		_fail_token(token, ERR_FILE_CANT_OPEN);
 		return;
 	}
+	// Hash what is written rather than reading the entry a second time for verification.
+	// Without a directory MD5, the manifest needs the hash of what was written to notice later changes.
+	token.hashed = file->has_md5() ? should_check_md5 : incremental;
+	Span<uint8_t> span;
+	bool has_span = FileAccessMapped::get_span_for(pck_f, span);
+	// Unencrypted pack bytes are exactly the output bytes, so let the kernel copy them unless they have to be hashed
+	// and aren't already mapped.
+	if (sink->can_copy_range() && (!token.hashed || has_span) && GDREPackedData::get_singleton()->is_raw_pack_entry(file->pf)) {
+		if (token.hashed) {
+			CryptoCore::md5(span.ptr(), span.size(), token.md5);
+		}
+		token.kernel_copy = true;
+	} else if (file->get_size() <= PIPELINE_MAX_BUFFERED) {
+		token.data.resize(file->get_size());
+		if (has_span) {
+			memcpy(token.data.ptrw(), span.ptr(), span.size());
+		} else {
+			uint64_t got = pck_f->get_buffer(token.data.ptrw(), token.data.size());
+			if (got != file->get_size()) {
+				_fail_token(token, ERR_FILE_CANT_OPEN);
+				return;
+			}
+		}
+		if (token.hashed) {
+			CryptoCore::md5(token.data.ptr(), token.data.size(), token.md5);
+		}
+	} else {
+		err = _copy_entry(token, pck_f);
+		if (err != OK) {
+			_fail_token(token, err);
+		} else {
+			_finish_token(token);
+		}
+		return;
+	}
+	_queue_write(i);
+}
+
+// Blocks while the writers are behind, which bounds the memory held by buffered entries.
+void PckDumper::_queue_write(uint32_t p_idx) {
+	write_queue_slots.wait();
+	write_queue.push(p_idx);
+	write_queue_items.post();
+}
 
-	int64_t rq_size = file->get_size();
-	uint8_t buf[16384];
-	while (rq_size > 0) {
-		int got = pck_f->get_buffer(buf, MIN(16384, rq_size));
-		fa->store_buffer(buf, got);
-		rq_size -= 16384;
+// Writer stage: runs on its own threads so file creation and writes don't occupy worker pool slots.
+void PckDumper::_write_token(ExtractToken &p_token) {
+	Error err = OK;
+	if (p_token.kernel_copy) {
+		const Ref<PackedFileInfo> &file = p_token.file;
+		err = sink->copy_range(p_token.rel_path, file->get_pack(), file->get_offset(), file->get_size());
+		if (err == ERR_CANT_CREATE) {
+			_fail_token(p_token, err);
+			return;
+		} else if (err != OK) {
+			// Not supported here; copy it through the pack instead (already hashed if needed).
+			Ref<FileAccess> pck_f = FileAccess::open(file->get_path(), FileAccess::READ);
+			if (pck_f.is_null()) {
+				_fail_token(p_token, ERR_FILE_CANT_OPEN);
+				return;
+			}
+			bool hashed = p_token.hashed;
+			p_token.hashed = false;
+			err = _copy_entry(p_token, pck_f);
+			p_token.hashed = hashed;
+			if (err != OK) {
+				_fail_token(p_token, err);
+				return;
+			}
+		}
+	} else {
+		err = sink->write_file(p_token.rel_path, p_token.data.ptr(), p_token.data.size());
+		if (err != OK) {
+			_fail_token(p_token, err == ERR_CANT_CREATE ? err : ERR_FILE_CANT_WRITE);
+			return;
+		}
 	}
-	fa->flush();
-	completed_cnt++;
-	if (file->is_malformed() && file->get_raw_path() != file->get_path()) {
-		print_line("Warning: " + file->get_raw_path() + " is a malformed path!\nSaving to " + file->get_path() + " instead.");
+	_finish_token(p_token);
+}
+
+void PckDumper::_writer_thread_func(void *p_userdata) {
+	PckDumper *dumper = static_cast<PckDumper *>(p_userdata);
+	while (true) {
+		dumper->write_queue_items.wait();
+		uint32_t idx = dumper->write_queue.pop();
+		dumper->write_queue_slots.post();
+		if (idx == WRITER_STOP) {
+			return;
+		}
+		dumper->_write_token(dumper->extract_tokens[idx]);
 	}
-	print_verbose("Extracted " + target_name);
 }
 
 Error PckDumper::_pck_dump_to_dir(
 		const String &dir,
 		const Vector<String> &files_to_extract,
-		String &error_string) {
+		String &error_string,
+		bool p_verify_md5,
+		bool p_incremental) {
 	ERR_FAIL_COND_V_MSG(!GDRESettings::get_singleton()->is_pack_loaded(), ERR_DOES_NOT_EXIST,
 			"Pack not loaded!");
 	reset();
 	output_dir = dir;
+	sink = ExtractSink::create(dir);
+	if (sink.is_null()) {
+		return ERR_FILE_CANT_WRITE;
+	}
+	// Archives are rewritten from scratch, so there is nothing to compare against.
+	incremental = p_incremental && sink->is_directory();
+	auto pack_type = GDRESettings::get_singleton()->get_pack_type();
+	should_check_md5 = p_verify_md5 && (pack_type == GDRESettings::PackInfo::PCK || pack_type == GDRESettings::PackInfo::EXE);
 	auto files = GDRESettings::get_singleton()->get_file_info_list();
 
 	if (DirAccess::create(DirAccess::ACCESS_FILESYSTEM).is_null()) {
@@ -190,7 +438,19 @@ Error PckDumper::_pck_dump_to_dir(
 		tokens.push_back({ files.get(i), OK });
 	}
 	tokens.resize(actual);
+	TaskManager::sort_by_io_locality(tokens, [](const ExtractToken &p_token) { return get_file_locality(p_token.file); });
+	token_count = tokens.size();
 
+	if (incremental) {
+		gdre::ensure_dir(output_dir);
+		_load_manifest();
+	}
+
+	extract_tokens = tokens.ptrw();
+	write_queue_slots.post(WRITE_QUEUE_SIZE);
+	for (int i = 0; i < WRITER_THREADS; i++) {
+		writer_threads[i].start(&PckDumper::_writer_thread_func, this);
+	}
 	err = TaskManager::get_singleton()->run_multithreaded_group_task(
 			this,
 			&PckDumper::_do_extract,
@@ -202,10 +462,36 @@ Error PckDumper::_pck_dump_to_dir(
 			true,
 			-1,
 			true);
-	files_extracted = completed_cnt;
+	// Let the writers drain what the readers queued, then stop them.
+	for (int i = 0; i < WRITER_THREADS; i++) {
+		_queue_write(WRITER_STOP);
+	}
+	for (int i = 0; i < WRITER_THREADS; i++) {
+		writer_threads[i].wait_to_finish();
+	}
+	// The queue is empty again; take back the slots so the next run starts from zero.
+	while (write_queue_slots.try_wait()) {
+	}
+	extract_tokens = nullptr;
+	Error sink_err = sink->finish();
+	sink.unref();
+	if (incremental) {
+		_finish_manifest();
+	}
+	files_extracted = completed_cnt - unchanged_cnt;
+	if (unchanged_cnt > 0) {
+		print_line("Skipped " + itos(unchanged_cnt) + " unchanged files");
+	}
+	if (encryption_error) {
+		GDRESettings::get_singleton()->_set_error_encryption(encryption_error);
+	}
 	if (broken_cnt > 0) {
-		err = ERR_BUG;
+		// Only checksum mismatches: every file was still written, so let callers tell that apart.
+		err = ERR_FILE_CORRUPT;
 		for (int i = 0; i < tokens.size(); i++) {
+			if (tokens[i].err != OK && tokens[i].err != ERR_FILE_CORRUPT) {
+				err = ERR_BUG;
+			}
 			if (tokens[i].err != OK) {
 				String err_type;
 				if (tokens[i].err == ERR_FILE_CANT_OPEN) {
@@ -214,17 +500,24 @@ Error PckDumper::_pck_dump_to_dir(
 					err_type = "FileCreate error";
 				} else if (tokens[i].err == ERR_FILE_CANT_WRITE) {
 					err_type = "FileWrite error";
+				} else if (tokens[i].err == ERR_FILE_CORRUPT) {
+					err_type = "Checksum mismatch";
 				} else {
 					err_type = "Unknown error";
 				}
 				error_string += tokens[i].file->get_path() + "(" + err_type + ")\n";
 			}
-			if (files.get(i)->is_malformed() && files.get(i)->get_raw_path() != files.get(i)->get_path()) {
-				print_line("Warning: " + files.get(i)->get_raw_path() + " is a malformed path!\nSaving to " + files.get(i)->get_path() + " instead.");
+			if (tokens[i].file->is_malformed() && tokens[i].file->get_raw_path() != tokens[i].file->get_path()) {
+				print_line("Warning: " + tokens[i].file->get_raw_path() + " is a malformed path!\nSaving to " + tokens[i].file->get_path() + " instead.");
 			}
 		}
 	}
 
+	if (sink_err != OK) {
+		error_string += dir + "(FileWrite error)\n";
+		err = ERR_FILE_CANT_WRITE;
+	}
+
 	if (error_string.length() > 0) {
 		print_error("At least one error was detected while extracting pack!\n" + error_string);
 		//show_warning(failed_files, RTR("Read PCK"), RTR("At least one error was detected!"));
@@ -248,6 +541,6 @@ String PckDumper::get_extract_token_description(int64_t p_index, ExtractToken *p
 
 void PckDumper::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("check_md5_all_files"), &PckDumper::check_md5_all_files);
-	ClassDB::bind_method(D_METHOD("pck_dump_to_dir", "dir", "files_to_extract"), &PckDumper::pck_dump_to_dir, DEFVAL(Vector<String>()));
+	ClassDB::bind_method(D_METHOD("pck_dump_to_dir", "dir", "files_to_extract", "verify_md5", "incremental"), &PckDumper::pck_dump_to_dir, DEFVAL(Vector<String>()), DEFVAL(false), DEFVAL(false));
 	//ClassDB::bind_method(D_METHOD("get_dumped_files"), &PckDumper::get_dumped_files);
 }
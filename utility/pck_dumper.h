@@ -3,8 +3,13 @@
 
 #include "core/object/object.h"
 #include "core/object/ref_counted.h"
+#include "core/os/mutex.h"
+#include "core/os/semaphore.h"
+#include "core/os/thread.h"
+#include "utility/gd_parallel_queue.h"
 
 #include "packed_file_info.h"
+#include "utility/extract_sink.h"
 class PckDumper : public RefCounted {
 	GDCLASS(PckDumper, RefCounted)
 	bool skip_malformed_paths = false;
@@ -15,15 +20,78 @@ class PckDumper : public RefCounted {
 	std::atomic<int> completed_cnt = 0;
 	std::atomic<int> skipped_cnt = 0;
 	std::atomic<int> broken_cnt = 0;
+	// Work is sorted by pack offset; each task hints the entry PREFETCH_AHEAD places further on.
+	static constexpr uint32_t PREFETCH_AHEAD = 8;
+	uint32_t token_count = 0;
+
+	// Incremental extraction: a manifest in the output dir records the content MD5 written for each file, so unchanged
+	// files can be skipped; entries with an MD5 in the pack directory aren't even read. Entries are journaled as files
+	// finish, so interrupted runs resume.
+	struct ManifestEntry {
+		String signature;
+		uint64_t size = 0;
+		uint64_t mtime = 0;
+	};
+	static constexpr const char *MANIFEST_NAME = ".gdre_extract_manifest";
+	bool incremental = false;
+	std::atomic<int> unchanged_cnt = 0;
+	Mutex manifest_mutex;
+	HashMap<String, ManifestEntry> manifest;
+	Ref<FileAccess> manifest_journal;
+
+	static String _get_file_signature(const Ref<PackedFileInfo> &p_file);
+	void _load_manifest();
+	void _record_manifest(const String &p_path, const ManifestEntry &p_entry);
+	void _finish_manifest();
+	bool _is_up_to_date(const Ref<PackedFileInfo> &p_file, const String &p_target);
 
 	bool _pck_file_check_md5(Ref<PackedFileInfo> &file);
+	// Used by both verification (over file infos) and extraction (over tokens).
+	template <typename T>
+	void _prefetch_ahead(uint32_t i, const T *p_items);
 	void _do_md5_check(uint32_t i, Ref<PackedFileInfo> *tokens);
 	String get_file_description(int64_t i, Ref<PackedFileInfo> *userdata);
 	void reset();
 	struct ExtractToken {
 		Ref<PackedFileInfo> file;
 		Error err = OK;
+		// Path relative to the output root, and where it ends up (for messages and the manifest).
+		String rel_path;
+		String target;
+		// Filled by the reader stage for the writers.
+		Vector<uint8_t> data;
+		bool kernel_copy = false;
+		// MD5 of the extracted bytes, computed when verifying, or as the manifest signature of entries the directory
+		// has no MD5 for.
+		bool hashed = false;
+		uint8_t md5[16] = {};
+		bool md5_passed = false;
 	};
+	static const Ref<PackedFileInfo> &_get_item_file(const Ref<PackedFileInfo> &p_file) { return p_file; }
+	static const Ref<PackedFileInfo> &_get_item_file(const ExtractToken &p_token) { return p_token.file; }
+
+	// Extraction is a pipeline: worker pool tasks read (and decrypt and hash) entries and queue small ones for a
+	// separate pool of writer threads. The queue is bounded, so at most WRITE_QUEUE_SIZE entries of up to
+	// PIPELINE_MAX_BUFFERED bytes are held in memory; larger entries are streamed by the reader itself.
+	static constexpr int WRITER_THREADS = 4;
+	static constexpr unsigned WRITE_QUEUE_SIZE = 64;
+	static constexpr uint64_t PIPELINE_MAX_BUFFERED = 1024 * 1024;
+	static constexpr uint32_t WRITER_STOP = UINT32_MAX;
+	StaticParallelQueue<uint32_t, WRITE_QUEUE_SIZE> write_queue;
+	// Free slots and queued items, so readers block while the queue is full and writers sleep while it is empty.
+	Semaphore write_queue_slots;
+	Semaphore write_queue_items;
+	Thread writer_threads[WRITER_THREADS];
+	ExtractToken *extract_tokens = nullptr;
+	// Output directory, or a tar/zip archive if the output path ends in ".tar" or ".zip".
+	Ref<ExtractSink> sink;
+
+	void _fail_token(ExtractToken &p_token, Error p_err);
+	void _finish_token(ExtractToken &p_token);
+	Error _copy_entry(ExtractToken &p_token, Ref<FileAccess> p_src);
+	void _write_token(ExtractToken &p_token);
+	void _queue_write(uint32_t p_idx);
+	static void _writer_thread_func(void *p_userdata);
 	void _do_extract(uint32_t i, ExtractToken *tokens);
 	String get_extract_token_description(int64_t i, ExtractToken *userdata);
 
@@ -36,8 +104,12 @@ public:
 	Error check_md5_all_files();
 	Error _check_md5_all_files(Vector<String> &broken_files, int &checked_files);
 
-	Error _pck_dump_to_dir(const String &dir, const Vector<String> &files_to_extract, String &error_string);
-	Error pck_dump_to_dir(const String &dir, const Vector<String> &files_to_extract);
+	// With p_verify_md5, each entry is hashed as it is written and mismatches are reported per file at the end,
+	// so a separate check_md5_all_files pass isn't needed.
+	// With p_incremental, files already extracted with identical contents are skipped.
+	// If dir ends in ".tar" or ".zip", files are written into that archive instead (incremental mode is ignored).
+	Error _pck_dump_to_dir(const String &dir, const Vector<String> &files_to_extract, String &error_string, bool p_verify_md5 = false, bool p_incremental = false);
+	Error pck_dump_to_dir(const String &dir, const Vector<String> &files_to_extract, bool verify_md5 = false, bool incremental = false);
 
 	//Error pck_dump_to_dir(const String &dir, const Vector<String> &files_to_extract);
 };
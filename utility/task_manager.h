@@ -1,6 +1,7 @@
 #pragma once
 #include "core/error/error_macros.h"
 #include "core/object/worker_thread_pool.h"
+#include "core/templates/local_vector.h"
 #include "utility/gd_parallel_hashmap.h"
 #include "utility/gd_parallel_queue.h"
 #include "utility/gdre_config.h"
@@ -287,6 +288,47 @@ protected:
 	std::atomic<GroupTaskID> current_group_task_id = 0;
 
 public:
+	// Where an element's input lives, so work that reads from packs can be dispatched in file order.
+	// Elements outside of any pack have an empty pack path.
+	struct IOLocalityKey {
+		String pack;
+		uint64_t offset = 0;
+
+		bool operator<(const IOLocalityKey &p_other) const {
+			return pack == p_other.pack ? offset < p_other.offset : pack < p_other.pack;
+		}
+	};
+
+	// Group tasks hand out element indices in ascending order, so sorting the elements by locality turns
+	// random reads across a pack into a mostly sequential sweep. The sort is stable.
+	template <typename T, typename F>
+	static void sort_by_io_locality(Vector<T> &r_elements, F p_get_key) {
+		struct Item {
+			IOLocalityKey key;
+			int idx = 0;
+			bool operator<(const Item &p_other) const {
+				if (key < p_other.key) {
+					return true;
+				}
+				return !(p_other.key < key) && idx < p_other.idx;
+			}
+		};
+		LocalVector<Item> items;
+		items.resize(r_elements.size());
+		for (int i = 0; i < r_elements.size(); i++) {
+			items[i].key = p_get_key(r_elements[i]);
+			items[i].idx = i;
+		}
+		items.sort();
+		Vector<T> sorted;
+		sorted.resize(r_elements.size());
+		T *dst = sorted.ptrw();
+		for (uint32_t i = 0; i < items.size(); i++) {
+			dst[i] = std::move(r_elements.write[items[i].idx]);
+		}
+		r_elements = std::move(sorted);
+	}
+
 	TaskManager();
 	~TaskManager();
 	static TaskManager *get_singleton();